@@ -0,0 +1,895 @@
+/*
+  ==============================================================================
+
+    Headless benchmarks, see EditorBenchmark.h
+
+  ==============================================================================
+*/
+
+#include "EditorBenchmark.h"
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/PluginEditor.h"
+#include "../../Source/TraceRecorder.h"
+#include "../../Source/SpectrumKernels.h"
+
+#include <chrono>
+#include <complex>
+#include <thread>
+
+#if JUCE_LINUX
+ #include <pthread.h>
+ #include <sched.h>
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+ #include <ctime>
+#endif
+
+namespace
+{
+// a slow sweep plus some noise, so every analyzer column moves from frame to frame
+struct SyntheticSignal
+{
+  void fill(juce::AudioBuffer<float> &buffer, double sampleRate)
+  {
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    {
+      auto frequency = 40.0 * std::pow(400.0, 0.5 + 0.5 * std::sin(sweepPhase));
+      sinePhase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+      sweepPhase += juce::MathConstants<double>::twoPi * 0.1 / sampleRate;
+
+      auto sine = 0.5f * (float)std::sin(sinePhase);
+      for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        buffer.setSample(channel, i, sine + 0.05f * (random.nextFloat() * 2.f - 1.f));
+    }
+  }
+
+  double sinePhase = 0.0, sweepPhase = 0.0;
+  juce::Random random{1234};
+};
+
+void feedOneFrame(SimpleEqAudioProcessor &processor, juce::AudioBuffer<float> &buffer,
+                  SyntheticSignal &signal, const EditorBenchmarkOptions &options)
+{
+  juce::MidiBuffer midi;
+  auto samplesPerFrame = options.sampleRate / options.frameRateHz;
+  auto numBlocks = juce::jmax(1, (int)std::ceil(samplesPerFrame / options.blockSize));
+
+  for (int b = 0; b < numBlocks; ++b)
+  {
+    signal.fill(buffer, options.sampleRate);
+    processor.processBlock(buffer, midi);
+  }
+}
+
+void tickResponseCurves(juce::Component &editor)
+{
+  // the editor is not on screen so the render scheduler would throttle it, tick it like a visible one
+  for (auto *child : editor.getChildren())
+    if (auto *curve = dynamic_cast<ResponseCurveComponent *>(child))
+      curve->renderTick();
+}
+
+double renderFrame(juce::Component &editor, juce::Image &image, float scale);
+
+juce::var measureEditorOpen(const EditorBenchmarkOptions &options)
+{
+  std::vector<std::unique_ptr<SimpleEqAudioProcessor>> processors;
+  std::vector<std::unique_ptr<juce::AudioProcessorEditor>> editors;
+  std::vector<double> openTimes;
+
+  for (int i = 0; i < options.editorsToOpen; ++i)
+  {
+    processors.push_back(std::make_unique<SimpleEqAudioProcessor>());
+    auto &processor = *processors.back();
+    processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+    processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+    auto start = juce::Time::getMillisecondCounterHiRes();
+    editors.emplace_back(processor.createEditorIfNeeded());
+    auto &editor = *editors.back();
+    juce::Image image(juce::Image::ARGB, editor.getWidth(), editor.getHeight(), true);
+    renderFrame(editor, image, 1.f);
+    tickResponseCurves(editor);
+    openTimes.push_back(juce::Time::getMillisecondCounterHiRes() - start);
+  }
+
+  // editors first, they reference their processor
+  editors.clear();
+  processors.clear();
+
+  auto *result = new juce::DynamicObject();
+  if (!openTimes.empty())
+  {
+    result->setProperty("coldMs", openTimes.front());
+    result->setProperty("warm", PaintProfiler::summarise({openTimes.begin() + 1, openTimes.end()}));
+  }
+  return juce::var(result);
+}
+
+double renderFrame(juce::Component &editor, juce::Image &image, float scale)
+{
+  auto start = juce::Time::getMillisecondCounterHiRes();
+  {
+    juce::Graphics g(image);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    editor.paintEntireComponent(g, true);
+  }
+  return juce::Time::getMillisecondCounterHiRes() - start;
+}
+}
+
+juce::var runEditorBenchmark(const EditorBenchmarkOptions &options)
+{
+  juce::Array<juce::var> runs;
+  auto &profiler = PaintProfiler::getInstance();
+  profiler.setEnabled(false);
+
+  // before anything else so the shared resources really are cold
+  auto open = measureEditorOpen(options);
+
+  SimpleEqAudioProcessor processor;
+  processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+  processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+  juce::AudioBuffer<float> buffer(2, options.blockSize);
+  SyntheticSignal signal;
+
+  auto *modeParameter = dynamic_cast<juce::AudioParameterChoice *>(processor.apvts.getParameter("Analyzer Mode"));
+  jassert(modeParameter != nullptr);
+
+  {
+    std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditorIfNeeded());
+
+    for (auto &mode : options.analyzerModes)
+    {
+      auto modeIndex = modeParameter->choices.indexOf(mode);
+      if (modeIndex < 0)
+        continue;
+      // the editor picks it up on its next tick, the warm up frames cover the switch
+      modeParameter->setValueNotifyingHost(modeParameter->convertTo0to1((float)modeIndex));
+
+      for (auto size : options.sizes)
+      {
+        for (auto scale : options.scaleFactors)
+        {
+          editor->setSize(size.x, size.y);
+          juce::Image image(juce::Image::ARGB, juce::roundToInt(size.x * scale), juce::roundToInt(size.y * scale), true);
+
+          profiler.setEnabled(false);
+          for (int frame = 0; frame < options.warmupFrames; ++frame)
+          {
+            feedOneFrame(processor, buffer, signal, options);
+            tickResponseCurves(*editor);
+            renderFrame(*editor, image, scale);
+          }
+
+          profiler.reset();
+          profiler.setEnabled(true);
+          std::vector<double> frameTimes;
+          frameTimes.reserve(options.framesPerRun);
+
+          for (int frame = 0; frame < options.framesPerRun; ++frame)
+          {
+            feedOneFrame(processor, buffer, signal, options);
+            auto start = juce::Time::getMillisecondCounterHiRes();
+            tickResponseCurves(*editor);
+            auto tickTime = juce::Time::getMillisecondCounterHiRes() - start;
+            frameTimes.push_back(tickTime + renderFrame(*editor, image, scale));
+          }
+          profiler.setEnabled(false);
+
+          auto *run = new juce::DynamicObject();
+          run->setProperty("analyzerMode", mode);
+          run->setProperty("width", size.x);
+          run->setProperty("height", size.y);
+          run->setProperty("scale", scale);
+          run->setProperty("frame", PaintProfiler::summarise(frameTimes));
+          run->setProperty("sections", profiler.toVar());
+          runs.add(juce::var(run));
+        }
+      }
+    }
+  }
+
+  processor.releaseResources();
+
+  auto *result = new juce::DynamicObject();
+  result->setProperty("sampleRate", options.sampleRate);
+  result->setProperty("blockSize", options.blockSize);
+  result->setProperty("framesPerRun", options.framesPerRun);
+  result->setProperty("open", open);
+  result->setProperty("runs", runs);
+  return juce::var(result);
+}
+
+juce::String runEditorBenchmarkToJson(const EditorBenchmarkOptions &options)
+{
+  return juce::JSON::toString(runEditorBenchmark(options));
+}
+
+juce::var runMorphBenchmark(const EditorBenchmarkOptions &options, int numBlocks)
+{
+  SimpleEqAudioProcessor processor;
+  processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+  processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+  juce::AudioBuffer<float> buffer(2, options.blockSize);
+  juce::MidiBuffer midi;
+  SyntheticSignal signal;
+
+  // A : the defaults, B : every band far from them
+  processor.storeSnapshot(0);
+  auto b = getChainSettings(processor.apvts);
+  b.lowCutFreq = 120.f;
+  b.lowCutSlope = Slope_48;
+  b.highCutFreq = 8000.f;
+  b.highCutSlope = Slope_24;
+  b.peakFreq = 3000.f;
+  b.peakGainInDecibels = 12.f;
+  b.peakQuality = 4.f;
+  setChainSettings(processor.apvts, b);
+  processor.storeSnapshot(1);
+  processor.recallSnapshot(0);
+
+  std::vector<double> staticTimes, morphTimes, designTimes;
+  staticTimes.reserve(numBlocks);
+  morphTimes.reserve(numBlocks);
+  designTimes.reserve(numBlocks);
+
+  for (int i = 0; i < numBlocks; ++i)
+  {
+    signal.fill(buffer, options.sampleRate);
+    auto start = juce::Time::getMillisecondCounterHiRes();
+    processor.processBlock(buffer, midi);
+    staticTimes.push_back(juce::Time::getMillisecondCounterHiRes() - start);
+  }
+
+  for (int i = 0; i < numBlocks; ++i)
+  {
+    signal.fill(buffer, options.sampleRate);
+    auto start = juce::Time::getMillisecondCounterHiRes();
+    processor.setMorph(0, 1, float(i) / float(numBlocks - 1));
+    auto designed = juce::Time::getMillisecondCounterHiRes();
+    processor.processBlock(buffer, midi);
+    designTimes.push_back(designed - start);
+    morphTimes.push_back(juce::Time::getMillisecondCounterHiRes() - designed);
+  }
+  processor.endMorph(false);
+  processor.releaseResources();
+
+  auto *morph = new juce::DynamicObject();
+  morph->setProperty("processBlock", PaintProfiler::summarise(morphTimes));
+  morph->setProperty("setMorph", PaintProfiler::summarise(designTimes));
+
+  auto *result = new juce::DynamicObject();
+  result->setProperty("blockSize", options.blockSize);
+  result->setProperty("static", PaintProfiler::summarise(staticTimes));
+  result->setProperty("morph", juce::var(morph));
+  return juce::var(result);
+}
+
+namespace
+{
+// resident set size of the process, -1 when the platform doesn't tell
+juce::int64 getResidentBytes()
+{
+#if JUCE_LINUX
+  // second field of statm, in pages
+  auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), false);
+  if (fields.size() > 1)
+    return fields[1].getLargeIntValue() * (juce::int64)sysconf(_SC_PAGESIZE);
+#endif
+  return -1;
+}
+
+// cpu time of the calling thread, falls back to wall time
+double getThreadCpuMs()
+{
+#if JUCE_LINUX
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+#endif
+  return juce::Time::getMillisecondCounterHiRes();
+}
+
+// hardware cache misses of the calling thread, unavailable without perf access (perf_event_paranoid)
+struct CacheMissCounter
+{
+  CacheMissCounter()
+  {
+#if JUCE_LINUX
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~CacheMissCounter()
+  {
+#if JUCE_LINUX
+    if (fd >= 0)
+      close(fd);
+#endif
+  }
+
+  bool isAvailable() const { return fd >= 0; }
+
+  void start()
+  {
+#if JUCE_LINUX
+    if (fd >= 0)
+    {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  juce::int64 stop()
+  {
+    juce::int64 count = 0;
+#if JUCE_LINUX
+    if (fd >= 0)
+    {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count))
+        count = 0;
+    }
+#endif
+    return count;
+  }
+
+  int fd = -1;
+};
+
+struct Instance
+{
+  std::unique_ptr<SimpleEqAudioProcessor> processor;
+  std::unique_ptr<juce::AudioProcessorEditor> editor;
+  juce::AudioBuffer<float> buffer;
+};
+
+juce::var memoryReportToVar(const SimpleEqAudioProcessor::MemoryReport &report)
+{
+  auto *object = new juce::DynamicObject();
+  object->setProperty("processor", (juce::int64)report.processor);
+  object->setProperty("analyzerFifos", (juce::int64)report.analyzerFifos);
+  object->setProperty("editorAnalyzer", (juce::int64)report.editorAnalyzer);
+  object->setProperty("editorCurve", (juce::int64)report.editorCurve);
+  object->setProperty("perInstance", (juce::int64)report.perInstance());
+  object->setProperty("sharedTables", (juce::int64)report.sharedTables);
+  return juce::var(object);
+}
+}
+
+juce::var runInstanceScalingBenchmark(const EditorBenchmarkOptions &options, juce::Array<int> counts, int blocksPerInstance)
+{
+  juce::Array<juce::var> runs;
+  CacheMissCounter cacheMisses;
+  SyntheticSignal signal;
+  juce::MidiBuffer midi;
+
+  // one block of input copied into every instance, like a host handing out its track buffers
+  juce::AudioBuffer<float> input(2, options.blockSize);
+  signal.fill(input, options.sampleRate);
+  const auto blockMs = 1000.0 * options.blockSize / options.sampleRate;
+  const auto blocksPerFrame = juce::jmax(1, juce::roundToInt(options.sampleRate / options.frameRateHz / options.blockSize));
+
+  for (auto count : counts)
+  {
+    for (auto editorOpen : {false, true})
+    {
+      auto residentBefore = getResidentBytes();
+      std::vector<Instance> instances((size_t)count);
+      juce::Image frame(juce::Image::ARGB, 600, 480, true);
+
+      for (auto &instance : instances)
+      {
+        instance.processor = std::make_unique<SimpleEqAudioProcessor>();
+        instance.processor->setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+        instance.processor->prepareToPlay(options.sampleRate, options.blockSize);
+        instance.buffer.setSize(2, options.blockSize);
+
+        if (editorOpen)
+        {
+          // one frame so the lazily created analyzer exists, as in a real open editor
+          instance.editor.reset(instance.processor->createEditorIfNeeded());
+          renderFrame(*instance.editor, frame, 1.f);
+          tickResponseCurves(*instance.editor);
+        }
+      }
+
+      auto residentAfter = getResidentBytes();
+      double audioCpuMs = 0.0, guiCpuMs = 0.0;
+      juce::int64 misses = 0;
+
+      for (int block = 0; block < blocksPerInstance; ++block)
+      {
+        cacheMisses.start();
+        auto start = getThreadCpuMs();
+        for (auto &instance : instances)
+        {
+          for (int channel = 0; channel < 2; ++channel)
+            instance.buffer.copyFrom(channel, 0, input, channel, 0, options.blockSize);
+          instance.processor->processBlock(instance.buffer, midi);
+        }
+        audioCpuMs += getThreadCpuMs() - start;
+        misses += cacheMisses.stop();
+
+        if (editorOpen && block % blocksPerFrame == 0)
+        {
+          auto guiStart = getThreadCpuMs();
+          for (auto &instance : instances)
+            tickResponseCurves(*instance.editor);
+          guiCpuMs += getThreadCpuMs() - guiStart;
+        }
+      }
+
+      auto numBlocks = (double)count * blocksPerInstance;
+      auto *run = new juce::DynamicObject();
+      run->setProperty("instances", count);
+      run->setProperty("editorOpen", editorOpen);
+      run->setProperty("sizeofProcessor", (int)sizeof(SimpleEqAudioProcessor));
+      run->setProperty("residentBytesPerInstance",
+                       residentBefore >= 0 && residentAfter >= 0 ? juce::var((residentAfter - residentBefore) / count) : juce::var());
+      // what the instance accounts for itself, next to what the OS sees
+      if (!instances.empty())
+        run->setProperty("memoryReport", memoryReportToVar(instances.front().processor->getMemoryReport()));
+      run->setProperty("audioCpuUsPerBlock", 1000.0 * audioCpuMs / numBlocks);
+      run->setProperty("realtimeLoadPerInstance", audioCpuMs / numBlocks / blockMs);
+      run->setProperty("cacheMissesPerBlock", cacheMisses.isAvailable() ? juce::var((double)misses / numBlocks) : juce::var());
+      if (editorOpen)
+        run->setProperty("guiTickUsPerInstancePerFrame",
+                         1000.0 * guiCpuMs / ((double)count * juce::jmax(1, blocksPerInstance / blocksPerFrame)));
+      runs.add(juce::var(run));
+
+      // editors before their processors
+      for (auto &instance : instances)
+        instance.editor.reset();
+    }
+  }
+
+  auto *result = new juce::DynamicObject();
+  result->setProperty("sampleRate", options.sampleRate);
+  result->setProperty("blockSize", options.blockSize);
+  result->setProperty("runs", runs);
+  return juce::var(result);
+}
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double toMicros(Clock::duration duration)
+{
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// the tail is what matters here, so the percentiles go further than PaintProfiler's
+juce::var summariseMicros(std::vector<double> values)
+{
+  auto *result = new juce::DynamicObject();
+  result->setProperty("count", (int)values.size());
+  if (!values.empty())
+  {
+    std::sort(values.begin(), values.end());
+    auto percentile = [&values](double p) { return values[juce::jmin(values.size() - 1, (size_t)(p * values.size()))]; };
+    result->setProperty("meanUs", std::accumulate(values.begin(), values.end(), 0.0) / values.size());
+    result->setProperty("p50Us", percentile(0.5));
+    result->setProperty("p99Us", percentile(0.99));
+    result->setProperty("p999Us", percentile(0.999));
+    result->setProperty("maxUs", values.back());
+  }
+  return juce::var(result);
+}
+
+bool requestRealtimePriority()
+{
+#if JUCE_LINUX
+  sched_param param{};
+  param.sched_priority = juce::jmin(80, sched_get_priority_max(SCHED_FIFO));
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+  return false;
+#endif
+}
+
+// sleeps most of the way, then spins : the scheduler alone wakes us up too late for small buffers
+void waitUntil(Clock::time_point when)
+{
+  std::this_thread::sleep_until(when - std::chrono::microseconds(300));
+  while (Clock::now() < when)
+  {
+  }
+}
+}
+
+juce::var runDeadlineSimulation(const EditorBenchmarkOptions &options, const DeadlineSimulationOptions &simulation)
+{
+  SimpleEqAudioProcessor processor;
+  processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+  processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+  // the states the host restores, made before anything runs
+  juce::Random random(42);
+  std::vector<juce::MemoryBlock> states(4);
+  for (auto &state : states)
+  {
+    for (auto *param : processor.getParameters())
+      param->setValueNotifyingHost(random.nextFloat());
+    processor.getStateInformation(state);
+  }
+
+  juce::Array<juce::RangedAudioParameter *> automated;
+  for (auto *id : {"LowCut Freq", "HighCut Freq", "Peak Freq", "Peak Gain", "Peak Quality", "LowCut Slope", "HighCut Slope"})
+    automated.add(processor.apvts.getParameter(id));
+
+  const auto blockPeriod = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(options.blockSize / options.sampleRate));
+  const auto numBlocks = juce::jmax(1, (int)(simulation.seconds * options.sampleRate / options.blockSize));
+
+  std::vector<double> processUs((size_t)numBlocks), latenessUs((size_t)numBlocks);
+  int deadlineMisses = 0, worstBlock = 0;
+  int automationChanges = 0, stateRestores = 0, analyzerFrames = 0;
+  bool realtime = false;
+  std::atomic<bool> running{true};
+
+  auto &tracer = TraceRecorder::getInstance();
+  const auto tracing = simulation.traceFile != juce::File();
+  if (tracing)
+  {
+    tracer.setEnabled(true);
+    tracer.clear();
+  }
+
+  std::thread audio([&]
+  {
+    realtime = requestRealtimePriority();
+    if (tracing)
+      tracer.setCurrentThreadName("Audio (simulated)");
+    juce::AudioBuffer<float> buffer(2, options.blockSize);
+    juce::MidiBuffer midi;
+    SyntheticSignal signal;
+
+    // a fixed grid like a device : a late block doesn't push the next releases back
+    auto start = Clock::now() + std::chrono::milliseconds(20);
+    for (int block = 0; block < numBlocks; ++block)
+    {
+      signal.fill(buffer, options.sampleRate);
+      auto release = start + blockPeriod * block;
+      waitUntil(release);
+
+      auto begin = Clock::now();
+      processor.processBlock(buffer, midi);
+      auto end = Clock::now();
+
+      latenessUs[(size_t)block] = toMicros(begin - release);
+      processUs[(size_t)block] = toMicros(end - begin);
+      if (end > release + blockPeriod)
+        ++deadlineMisses;
+      if (processUs[(size_t)block] > processUs[(size_t)worstBlock])
+        worstBlock = block;
+    }
+    running = false;
+  });
+
+  std::thread host([&]
+  {
+    juce::Random hostRandom(7);
+    if (tracing)
+      tracer.setCurrentThreadName("Host automation");
+    auto periodOf = [](double rateHz) {
+      return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rateHz));
+    };
+    auto nextAutomation = Clock::time_point::max(), nextRestore = Clock::time_point::max();
+    if (simulation.automationRateHz > 0.0)
+      nextAutomation = Clock::now();
+    if (simulation.stateRestoreRateHz > 0.0)
+      nextRestore = Clock::now();
+
+    while (running && (nextAutomation != Clock::time_point::max() || nextRestore != Clock::time_point::max()))
+    {
+      auto now = Clock::now();
+      if (now >= nextAutomation)
+      {
+        automated[hostRandom.nextInt(automated.size())]->setValueNotifyingHost(hostRandom.nextFloat());
+        ++automationChanges;
+        nextAutomation = juce::jmax(nextAutomation + periodOf(simulation.automationRateHz), now);
+      }
+      if (now >= nextRestore)
+      {
+        auto &state = states[(size_t)hostRandom.nextInt((int)states.size())];
+        processor.setStateInformation(state.getData(), (int)state.getSize());
+        ++stateRestores;
+        nextRestore = juce::jmax(nextRestore + periodOf(simulation.stateRestoreRateHz), now);
+      }
+      std::this_thread::sleep_until(juce::jmin(nextAutomation, nextRestore));
+    }
+  });
+
+  // the analyzer of an open editor, without the components : they belong to the message thread
+  std::thread analyzer([&]
+  {
+    if (!simulation.runAnalyzer)
+      return;
+
+    if (tracing)
+      tracer.setCurrentThreadName("Analyzer");
+    PathProducer producer(processor.leftChannelFifo, processor.rightChannelFifo);
+    auto framePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.frameRateHz));
+    auto next = Clock::now();
+    while (running)
+    {
+      producer.process({0.f, 0.f, 600.f, 300.f}, options.sampleRate);
+      ++analyzerFrames;
+      next += framePeriod;
+      std::this_thread::sleep_until(next);
+    }
+  });
+
+  audio.join();
+  host.join();
+  analyzer.join();
+
+  if (tracing)
+  {
+    tracer.setEnabled(false);
+    tracer.writeChromeTrace(simulation.traceFile);
+  }
+
+  const auto budgetUs = toMicros(blockPeriod);
+  juce::Array<juce::var> histogram;
+  for (auto fraction : {0.1, 0.25, 0.5, 0.75, 1.0})
+  {
+    auto *bucket = new juce::DynamicObject();
+    bucket->setProperty("upToBudgetFraction", fraction);
+    bucket->setProperty("blocks", (int)std::count_if(processUs.begin(), processUs.end(),
+                                                     [&](double us) { return us <= fraction * budgetUs; }));
+    histogram.add(juce::var(bucket));
+  }
+
+  auto *result = new juce::DynamicObject();
+  result->setProperty("sampleRate", options.sampleRate);
+  result->setProperty("blockSize", options.blockSize);
+  result->setProperty("budgetUs", budgetUs);
+  result->setProperty("realtimePriority", realtime);
+  result->setProperty("blocks", numBlocks);
+  result->setProperty("deadlineMisses", deadlineMisses);
+  result->setProperty("processUs", summariseMicros(processUs));
+  result->setProperty("wakeupLatenessUs", summariseMicros(latenessUs));
+  result->setProperty("blocksWithinBudget", histogram);
+  result->setProperty("worstBlockAtSeconds", worstBlock * options.blockSize / options.sampleRate);
+  result->setProperty("automationChanges", automationChanges);
+  result->setProperty("stateRestores", stateRestores);
+  result->setProperty("analyzerFrames", analyzerFrames);
+  return juce::var(result);
+}
+
+namespace
+{
+// worst magnitude error of a designed peak against its analog prototype, 20 Hz to 20 kHz (or just under Nyquist)
+double peakErrorDecibels(const BiquadResponse::Biquad &q, double sampleRate, const ChainSettings &settings)
+{
+  auto A = std::pow(10.0, settings.peakGainInDecibels / 40.0);
+  auto highest = juce::jmin(20000.0, 0.49 * sampleRate);
+  double worst = 0.0;
+
+  for (int i = 0; i < 512; ++i)
+  {
+    auto frequency = 20.0 * std::pow(highest / 20.0, i / 511.0);
+    auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    auto z1 = std::polar(1.0, -omega), z2 = std::polar(1.0, -2.0 * omega);
+    auto digital = std::abs(((double)q.b0 + (double)q.b1 * z1 + (double)q.b2 * z2) / (1.0 + (double)q.a1 * z1 + (double)q.a2 * z2));
+
+    auto x = frequency / settings.peakFreq;
+    auto real = 1.0 - x * x;
+    auto numerator = real * real + std::pow(x * A / settings.peakQuality, 2.0);
+    auto denominator = real * real + std::pow(x / (A * settings.peakQuality), 2.0);
+    auto analog = std::sqrt(numerator / denominator);
+
+    worst = juce::jmax(worst, std::abs(20.0 * std::log10(digital / analog)));
+  }
+  return worst;
+}
+}
+
+juce::var runPeakDesignBenchmark(const EditorBenchmarkOptions &options, int numBlocks)
+{
+  // accuracy : only the peak section, the oversampled rows ignore the response of the halfband filters
+  struct Bell
+  {
+    float frequency, gainDb, quality;
+  };
+  const Bell bells[] = {{16000.f, 12.f, 1.f}, {18000.f, -12.f, 2.f}, {10000.f, 6.f, 0.7f}, {4000.f, 12.f, 4.f}, {1000.f, -6.f, 1.f}};
+
+  juce::Array<juce::var> accuracy;
+  for (auto [frequency, gainDb, quality] : bells)
+  {
+    ChainSettings settings;
+    settings.peakFreq = frequency;
+    settings.peakGainInDecibels = gainDb;
+    settings.peakQuality = quality;
+    auto gain = juce::Decibels::decibelsToGain((double)gainDb);
+
+    auto *row = new juce::DynamicObject();
+    row->setProperty("frequency", frequency);
+    row->setProperty("gainDb", gainDb);
+    row->setProperty("quality", quality);
+    row->setProperty("bilinear", peakErrorDecibels(ChainDesign::peak(options.sampleRate, frequency, quality, gain),
+                                                   options.sampleRate, settings));
+    row->setProperty("matched", peakErrorDecibels(ChainDesign::peakMatched(options.sampleRate, frequency, quality, gain),
+                                                  options.sampleRate, settings));
+    for (int factor : {2, 4})
+    {
+      auto rate = options.sampleRate * factor;
+      row->setProperty("bilinear" + juce::String(factor) + "x",
+                       peakErrorDecibels(ChainDesign::peak(rate, frequency, quality, gain), rate, settings));
+    }
+    accuracy.add(juce::var(row));
+  }
+
+  // cost : the whole chain on a stereo block, with the oversampler's up and down filters for the 2x / 4x runs
+  ChainSettings settings;
+  settings.lowCutFreq = 20.f;
+  settings.highCutFreq = 20000.f;
+  settings.peakFreq = 16000.f;
+  settings.peakGainInDecibels = 12.f;
+  settings.peakQuality = 1.f;
+
+  juce::AudioBuffer<float> buffer(2, options.blockSize);
+  SyntheticSignal signal;
+
+  auto measure = [&](PeakDesign design, int oversamplingOrder)
+  {
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+    if (oversamplingOrder > 0)
+    {
+      oversampling = std::make_unique<juce::dsp::Oversampling<float>>(
+          2, (size_t)oversamplingOrder, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true);
+      oversampling->initProcessing((size_t)options.blockSize);
+    }
+
+    auto rate = options.sampleRate * (1 << oversamplingOrder);
+    juce::dsp::ProcessSpec spec{rate, (juce::uint32)(options.blockSize << oversamplingOrder), 1};
+    auto runSettings = settings;
+    runSettings.peakDesign = design;
+    auto coefficients = makeChainCoefficients(runSettings, rate);
+
+    MonoChain chains[2];
+    for (auto &chain : chains)
+    {
+      prepareChainForInPlaceUpdates(chain);
+      chain.prepare(spec);
+      applyChainCoefficients(chain, coefficients);
+    }
+
+    std::vector<double> times;
+    times.reserve((size_t)numBlocks);
+    for (int i = 0; i < numBlocks; ++i)
+    {
+      signal.fill(buffer, options.sampleRate);
+      auto start = Clock::now();
+
+      juce::dsp::AudioBlock<float> block(buffer);
+      auto processed = oversampling != nullptr ? oversampling->processSamplesUp(block) : block;
+      for (size_t channel = 0; channel < 2; ++channel)
+      {
+        auto channelBlock = processed.getSingleChannelBlock(channel);
+        processChainStages(chains[channel], juce::dsp::ProcessContextReplacing<float>(channelBlock));
+      }
+      if (oversampling != nullptr)
+        oversampling->processSamplesDown(block);
+
+      times.push_back(toMicros(Clock::now() - start));
+    }
+
+    auto *run = new juce::DynamicObject();
+    run->setProperty("design", design == PeakDesign_Matched ? "matched" : "bilinear");
+    run->setProperty("oversampling", 1 << oversamplingOrder);
+    run->setProperty("latencySamples", oversampling != nullptr ? (double)oversampling->getLatencyInSamples() : 0.0);
+    run->setProperty("processUs", summariseMicros(times));
+    return juce::var(run);
+  };
+
+  juce::Array<juce::var> cost;
+  cost.add(measure(PeakDesign_Bilinear, 0));
+  cost.add(measure(PeakDesign_Matched, 0));
+  cost.add(measure(PeakDesign_Bilinear, 1));
+  cost.add(measure(PeakDesign_Bilinear, 2));
+
+  auto *result = new juce::DynamicObject();
+  result->setProperty("sampleRate", options.sampleRate);
+  result->setProperty("blockSize", options.blockSize);
+  result->setProperty("maxErrorDb", accuracy);
+  result->setProperty("cost", cost);
+  return juce::var(result);
+}
+
+namespace
+{
+// the analyzer post-processing before SpectrumKernels : normalise and sanitise, then gainToDecibels per bin
+void twoPassDecibels(float *data, int numBins, float negativeInfinity)
+{
+  for (int i = 0; i < numBins; ++i)
+  {
+    auto v = data[i];
+    data[i] = std::isinf(v) || std::isnan(v) ? 0.f : v / float(numBins);
+  }
+
+  for (int i = 0; i < numBins; ++i)
+    data[i] = juce::Decibels::gainToDecibels(data[i], negativeInfinity);
+}
+}
+
+juce::var runSpectrumKernelBenchmark(int iterations)
+{
+  const float negativeInfinity = -120.f;
+  juce::Random random(7);
+  juce::Array<juce::var> runs;
+
+  for (auto order : {FFTOrder::order2048, FFTOrder::order4096, FFTOrder::order8192})
+  {
+    const int numBins = (1 << order) / 2;
+
+    // magnitudes from -130 dB to 0 dB once normalised, plus the values the sanitisation is there for
+    std::vector<float> magnitudes((size_t)numBins), powers((size_t)numBins);
+    for (int i = 0; i < numBins; ++i)
+      magnitudes[(size_t)i] = float(numBins) * std::pow(10.f, -6.5f * random.nextFloat());
+    magnitudes[1] = 0.f;
+    magnitudes[2] = std::numeric_limits<float>::infinity();
+    magnitudes[3] = std::numeric_limits<float>::quiet_NaN();
+    for (int i = 0; i < numBins; ++i)
+      powers[(size_t)i] = magnitudes[(size_t)i] * magnitudes[(size_t)i];
+
+    std::vector<float> reference(magnitudes), fused(powers), average((size_t)numBins, negativeInfinity), peaks(average);
+    twoPassDecibels(reference.data(), numBins, negativeInfinity);
+    SpectrumKernels::powerToDecibels(fused.data(), nullptr, nullptr, numBins, negativeInfinity);
+
+    double maxErrorDb = 0.0;
+    for (int i = 0; i < numBins; ++i)
+      maxErrorDb = juce::jmax(maxErrorDb, (double)std::abs(fused[(size_t)i] - reference[(size_t)i]));
+
+    // the input is copied back before every call, outside the timed part
+    auto measure = [&](const std::vector<float> &input, auto &&kernel)
+    {
+      std::vector<float> work(input);
+      std::vector<double> times;
+      times.reserve((size_t)iterations);
+      for (int i = 0; i < iterations; ++i)
+      {
+        std::copy(input.begin(), input.end(), work.begin());
+        auto start = Clock::now();
+        kernel(work.data());
+        times.push_back(toMicros(Clock::now() - start));
+      }
+      return summariseMicros(times);
+    };
+
+    SpectrumKernels::Smoothing smoothing{0.8f, 0.5f};
+    auto *run = new juce::DynamicObject();
+    run->setProperty("fftOrder", (int)order);
+    run->setProperty("numBins", numBins);
+    run->setProperty("twoPass", measure(magnitudes, [&](float *data)
+                                        { twoPassDecibels(data, numBins, negativeInfinity); }));
+    run->setProperty("powerToDecibels", measure(powers, [&](float *data)
+                                                { SpectrumKernels::powerToDecibels(data, nullptr, nullptr, numBins, negativeInfinity); }));
+    run->setProperty("powerToDecibelsSmoothed", measure(powers, [&](float *data)
+                                                        { SpectrumKernels::powerToDecibels(data, average.data(), peaks.data(), numBins,
+                                                                                           negativeInfinity, smoothing); }));
+    run->setProperty("maxErrorDb", maxErrorDb);
+    runs.add(juce::var(run));
+  }
+
+  auto *result = new juce::DynamicObject();
+  result->setProperty("simd", SIMPLEEQ_SPECTRUM_SSE2 != 0);
+  result->setProperty("runs", runs);
+  return juce::var(result);
+}
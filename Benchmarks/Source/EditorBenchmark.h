@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    Headless benchmarks : the editor paint paths, morphing, many instances
+    in one process, and the peak designs against oversampling.
+
+    Builds a processor and its editor, feeds synthetic audio through the
+    processor (so the analyzer FIFOs fill like in a host), and renders frames
+    into an offscreen juce::Image with paintEntireComponent, at several sizes
+    and scale factors. Nothing is put on the desktop, so it runs on a Linux
+    box without a display.
+
+    Built into the SimpleEqBenchmarks console app (SimpleEqBenchmarks.jucer),
+    never into the plugin, see Main.cpp for the command line.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct EditorBenchmarkOptions
+{
+  juce::Array<juce::Point<int>> sizes{{600, 480}, {900, 720}, {1200, 960}};
+  juce::Array<float> scaleFactors{1.f, 2.f};
+  int warmupFrames = 10;
+  int framesPerRun = 120;
+  double sampleRate = 48000.0;
+  int blockSize = 512;
+  // frames per second of audio fed between two renders, same as the render scheduler
+  int frameRateHz = 60;
+  // editors opened side by side (like a mixer view) for the open time measurement, the first one is the cold open
+  int editorsToOpen = 16;
+  // "Analyzer Mode" choices the frames are measured with, the resolution stays at its default (4096)
+  juce::StringArray analyzerModes{"Standard", "Multi-Resolution"};
+};
+
+/**
+ "open" : time from the editor constructor to the end of its first frame (paint + the tick that starts the analyzer).
+          coldMs is the first editor of the process, the others reuse the shared LookAndFeel and FFT tables.
+ "runs" : one entry per analyzer mode, size and scale factor, with the frame time and the PaintProfiler sections.
+          A mode that isn't one of the parameter's choices is skipped.
+ */
+juce::var runEditorBenchmark(const EditorBenchmarkOptions &options = {});
+juce::String runEditorBenchmarkToJson(const EditorBenchmarkOptions &options = {});
+
+/**
+ Per block cost of processBlock with a fixed chain, then during a morph sweep between two
+ snapshots with one setMorph() per block (its design time is reported apart, it runs on the
+ message thread in real use).
+ */
+juce::var runMorphBenchmark(const EditorBenchmarkOptions &options = {}, int numBlocks = 2000);
+
+/**
+ Creates 'count' processors for every count, with their editors closed then open, and processes
+ blocks round robin like a host. Per instance : resident memory, audio thread cpu per block and
+ its share of the real time budget, cache misses per block (Linux perf counters when allowed),
+ and with editors open the analyzer tick cost. Resident memory and cache figures are null where
+ the platform doesn't give them, the processor's own MemoryReport is always there.
+ */
+juce::var runInstanceScalingBenchmark(const EditorBenchmarkOptions &options = {},
+                                      juce::Array<int> counts = {1, 10, 100, 1000},
+                                      int blocksPerInstance = 200);
+
+struct DeadlineSimulationOptions
+{
+  double seconds = 10.0;
+  // parameter changes and setStateInformation() calls per second, both from the same host thread, 0 to disable
+  double automationRateHz = 500.0;
+  double stateRestoreRateHz = 4.0;
+  // an analyzer pulling the processor fifos at frameRateHz on a third thread, like an open editor
+  bool runAnalyzer = true;
+  // when set, the TraceRecorder runs during the simulation and its Chrome trace is written there
+  juce::File traceFile;
+};
+
+/**
+ Host simulator : processBlock runs on its own thread, released on the exact grid of
+ blockSize / sampleRate (SCHED_FIFO is asked for on Linux, "realtimePriority" says if it was granted)
+ while the other threads automate, restore states and run the analyzer.
+ Reports the distribution of the processBlock times and of the wake up lateness in microseconds,
+ a histogram of the block times against the budget, and the deadline misses : blocks that
+ finished after the release of the next one.
+ */
+juce::var runDeadlineSimulation(const EditorBenchmarkOptions &options = {},
+                                const DeadlineSimulationOptions &simulation = {});
+
+/**
+ The two peak designs (ChainDesign::peak, ChainDesign::peakMatched) against running the bilinear one oversampled.
+ "maxErrorDb" : for a few bells, the worst magnitude error against the analog prototype from 20 Hz to 20 kHz,
+                designed at the session rate and at 2x / 4x (the oversampler's own filters are left out).
+ "cost" : the time per stereo block of the whole chain, at the session rate for both designs and
+          inside a juce::dsp::Oversampling (halfband polyphase IIR) at 2x and 4x, with its latency.
+ */
+juce::var runPeakDesignBenchmark(const EditorBenchmarkOptions &options = {}, int numBlocks = 2000);
+
+/**
+ The analyzer post-processing : a copy of the old two-pass loop (normalise, then gainToDecibels per bin)
+ against SpectrumKernels::powerToDecibels, alone and with averaging and peak hold, for every FFT order.
+ "maxErrorDb" is the worst difference between the two outputs, floored at -120 dB.
+ */
+juce::var runSpectrumKernelBenchmark(int iterations = 2000);
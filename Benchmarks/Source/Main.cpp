@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    SimpleEqBenchmarks : command line front end of the headless benchmarks.
+    One command per benchmark, each prints its JSON report on stdout or
+    writes it to --out=<file>.
+
+        SimpleEqBenchmarks --editor --out=editor.json
+        SimpleEqBenchmarks --editor --analyzer-mode=Multi-Resolution
+        SimpleEqBenchmarks --morph --sample-rate=96000 --block-size=64
+        SimpleEqBenchmarks --instances --counts=1,10,100 --block-size=128
+        SimpleEqBenchmarks --deadline --block-size=64 --seconds=30 --trace=trace.json
+        SimpleEqBenchmarks --peak-design --sample-rate=44100 --blocks=4000
+
+    Linux : open SimpleEqBenchmarks.jucer in the Projucer, save, then
+        make -C Builds/LinuxMakefile CONFIG=Release
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "EditorBenchmark.h"
+
+#include <iostream>
+
+namespace
+{
+const char *const commonOptions = "[--sample-rate=<hz>] [--block-size=<samples>] [--out=<file>]";
+
+EditorBenchmarkOptions getOptions(const juce::ArgumentList &args)
+{
+  EditorBenchmarkOptions options;
+
+  if (args.containsOption("--sample-rate"))
+    options.sampleRate = args.getValueForOption("--sample-rate").getDoubleValue();
+  if (args.containsOption("--block-size"))
+    options.blockSize = args.getValueForOption("--block-size").getIntValue();
+
+  if (options.sampleRate <= 0.0)
+    juce::ConsoleApplication::fail("--sample-rate must be positive");
+  if (options.blockSize <= 0)
+    juce::ConsoleApplication::fail("--block-size must be positive");
+
+  return options;
+}
+
+void writeReport(const juce::ArgumentList &args, const juce::var &report)
+{
+  auto json = juce::JSON::toString(report);
+
+  if (!args.containsOption("--out"))
+  {
+    std::cout << json << std::endl;
+    return;
+  }
+
+  auto file = args.getFileForOption("--out");
+  if (!file.replaceWithText(json))
+    juce::ConsoleApplication::fail("Couldn't write " + file.getFullPathName());
+}
+}
+
+int main(int argc, char *argv[])
+{
+  // the editor benchmarks build components and images, they need the message manager
+  juce::ScopedJuceInitialiser_GUI gui;
+
+  juce::ConsoleApplication app;
+  app.addHelpCommand("--help|-h", "SimpleEqBenchmarks, headless benchmarks of the SimpleEq plugin", true);
+
+  app.addCommand({"--editor",
+                  juce::String("--editor [--analyzer-mode=<Standard|Multi-Resolution>] ") + commonOptions,
+                  "Editor open time and frame time per analyzer mode, size and scale factor",
+                  "See runEditorBenchmark() in EditorBenchmark.h, both analyzer modes are measured unless one is given",
+                  [](const juce::ArgumentList &args)
+                  {
+                    auto options = getOptions(args);
+                    if (args.containsOption("--analyzer-mode"))
+                    {
+                      auto mode = args.getValueForOption("--analyzer-mode");
+                      if (!options.analyzerModes.contains(mode))
+                        juce::ConsoleApplication::fail("--analyzer-mode must be one of " + options.analyzerModes.joinIntoString(", "));
+                      options.analyzerModes = juce::StringArray(mode);
+                    }
+                    writeReport(args, runEditorBenchmark(options));
+                  }});
+
+  app.addCommand({"--morph",
+                  juce::String("--morph [--blocks=<n>] ") + commonOptions,
+                  "processBlock cost with a fixed chain and during a snapshot morph",
+                  "See runMorphBenchmark() in EditorBenchmark.h",
+                  [](const juce::ArgumentList &args)
+                  {
+                    auto numBlocks = args.containsOption("--blocks") ? args.getValueForOption("--blocks").getIntValue() : 2000;
+                    writeReport(args, runMorphBenchmark(getOptions(args), juce::jmax(1, numBlocks)));
+                  }});
+
+  app.addCommand({"--instances",
+                  juce::String("--instances [--counts=1,10,100,1000] [--blocks=<per instance>] ") + commonOptions,
+                  "Memory, audio cpu and cache misses per instance, editors closed then open",
+                  "See runInstanceScalingBenchmark() in EditorBenchmark.h",
+                  [](const juce::ArgumentList &args)
+                  {
+                    juce::Array<int> counts{1, 10, 100, 1000};
+                    if (args.containsOption("--counts"))
+                    {
+                      counts.clear();
+                      for (auto &count : juce::StringArray::fromTokens(args.getValueForOption("--counts"), ",", ""))
+                        if (count.getIntValue() > 0)
+                          counts.add(count.getIntValue());
+                    }
+                    auto blocks = args.containsOption("--blocks") ? args.getValueForOption("--blocks").getIntValue() : 200;
+                    writeReport(args, runInstanceScalingBenchmark(getOptions(args), counts, juce::jmax(1, blocks)));
+                  }});
+
+  app.addCommand({"--deadline",
+                  juce::String("--deadline [--seconds=<s>] [--automation-rate=<hz>] [--state-rate=<hz>] [--no-analyzer] "
+                               "[--trace=<file>] ") + commonOptions,
+                  "Host simulator : processBlock on the block grid, deadline misses and their distribution",
+                  "See runDeadlineSimulation() in EditorBenchmark.h, --trace writes the Chrome trace of the run",
+                  [](const juce::ArgumentList &args)
+                  {
+                    DeadlineSimulationOptions simulation;
+                    if (args.containsOption("--seconds"))
+                      simulation.seconds = args.getValueForOption("--seconds").getDoubleValue();
+                    if (args.containsOption("--automation-rate"))
+                      simulation.automationRateHz = args.getValueForOption("--automation-rate").getDoubleValue();
+                    if (args.containsOption("--state-rate"))
+                      simulation.stateRestoreRateHz = args.getValueForOption("--state-rate").getDoubleValue();
+                    simulation.runAnalyzer = !args.containsOption("--no-analyzer");
+                    if (args.containsOption("--trace"))
+                      simulation.traceFile = args.getFileForOption("--trace");
+
+                    if (simulation.seconds <= 0.0)
+                      juce::ConsoleApplication::fail("--seconds must be positive");
+                    writeReport(args, runDeadlineSimulation(getOptions(args), simulation));
+                  }});
+
+  app.addCommand({"--spectrum-kernels",
+                  "--spectrum-kernels [--iterations=<n>] [--out=<file>]",
+                  "Old two-pass dB conversion against SpectrumKernels::powerToDecibels",
+                  "See runSpectrumKernelBenchmark() in EditorBenchmark.h",
+                  [](const juce::ArgumentList &args)
+                  {
+                    auto iterations = args.containsOption("--iterations") ? args.getValueForOption("--iterations").getIntValue() : 2000;
+                    writeReport(args, runSpectrumKernelBenchmark(juce::jmax(1, iterations)));
+                  }});
+
+  app.addCommand({"--peak-design",
+                  juce::String("--peak-design [--blocks=<n>] ") + commonOptions,
+                  "Magnitude error and chain cost of the bilinear and matched peaks against oversampling",
+                  "See runPeakDesignBenchmark() in EditorBenchmark.h",
+                  [](const juce::ArgumentList &args)
+                  {
+                    auto numBlocks = args.containsOption("--blocks") ? args.getValueForOption("--blocks").getIntValue() : 2000;
+                    writeReport(args, runPeakDesignBenchmark(getOptions(args), juce::jmax(1, numBlocks)));
+                  }});
+
+  return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    Batch evaluation of the frequency response of biquad cascades, used to draw
+    the response curve. Plain C++ (plus SSE2 when available).
+
+    The magnitude uses the sin^2(w/2) form of |H|^2 :
+        |H|^2 = [ (b0+b1+b2)^2 - 4(b0b1 + 4b0b2 + b1b2) phi + 16 b0b2 phi^2 ]
+              / [ (1+a1+a2)^2  - 4(a1 + 4a2 + a1a2)      phi + 16 a2   phi^2 ]
+        phi = sin^2(w/2)
+    The three polynomial coefficients are computed once per biquad in double, so
+    the per frequency work is two quadratics and a division, and there is no
+    1 + a1 cos(w) + ... cancellation at low frequencies.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define SIMPLEEQ_BIQUAD_SSE2 1
+#else
+ #define SIMPLEEQ_BIQUAD_SSE2 0
+#endif
+
+namespace BiquadResponse
+{
+// normalised coefficients, a0 == 1. First order sections just have b2 = a2 = 0
+struct Biquad
+{
+    float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+};
+
+// a band of the eq is a cascade of sections, e.g. the 4 stages of a cut filter
+struct Band
+{
+    const Biquad* sections = nullptr;
+    int numSections = 0;
+};
+
+/**
+ The frequencies the response is evaluated at, log spaced like the curve's pixel columns.
+ Only rebuild it when the number of points, the range or the sample rate change.
+ */
+struct FrequencyTable
+{
+    void build(int numPoints, double sampleRate, double minFrequency = 20.0, double maxFrequency = 20000.0)
+    {
+        size = std::max(0, numPoints);
+        rate = sampleRate;
+        low = minFrequency;
+        high = maxFrequency;
+
+        phi.resize(size);
+        cos1.resize(size);
+        sin1.resize(size);
+        cos2.resize(size);
+        sin2.resize(size);
+
+        for( int i = 0; i < size; ++i )
+        {
+            // same mapping as juce::mapToLog10
+            auto frequency = minFrequency * std::pow(maxFrequency / minFrequency, double(i) / double(size));
+            auto w = 2.0 * 3.14159265358979323846 * frequency / sampleRate;
+            auto s = std::sin(0.5 * w);
+
+            phi[i] = float(s * s);
+            cos1[i] = float(std::cos(w));
+            sin1[i] = float(std::sin(w));
+            cos2[i] = float(std::cos(2.0 * w));
+            sin2[i] = float(std::sin(2.0 * w));
+        }
+    }
+
+    bool matches(int numPoints, double sampleRate, double minFrequency = 20.0, double maxFrequency = 20000.0) const
+    {
+        return numPoints == size && sampleRate == rate && minFrequency == low && maxFrequency == high;
+    }
+
+    int size = 0;
+    double rate = 0.0, low = 0.0, high = 0.0;
+    std::vector<float> phi, cos1, sin1, cos2, sin2;
+};
+
+/**
+ Optional outputs of evaluate(), leave the pointers null to skip them.
+    bandDecibels[b] : magnitude of band b alone, table.size floats each
+    phase           : sum of the section phases (not unwrapped), in radians
+    groupDelay      : in samples
+ */
+struct ExtraOutputs
+{
+    float* const* bandDecibels = nullptr;
+    float* phase = nullptr;
+    float* groupDelay = nullptr;
+};
+
+namespace detail
+{
+struct MagnitudePolynomial
+{
+    float n0, n1, n2, d0, d1, d2;
+};
+
+inline MagnitudePolynomial toPolynomial(const Biquad& q)
+{
+    double b0 = q.b0, b1 = q.b1, b2 = q.b2, a1 = q.a1, a2 = q.a2;
+    auto sumB = b0 + b1 + b2;
+    auto sumA = 1.0 + a1 + a2;
+
+    return { float(sumB * sumB), float(-4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2)), float(16.0 * b0 * b2),
+             float(sumA * sumA), float(-4.0 * (a1 + 4.0 * a2 + a1 * a2)),          float(16.0 * a2) };
+}
+
+// keeps steep cascades away from denormals / zero, far below anything we draw
+constexpr float powerFloor = 1.0e-30f;
+
+// |H|^2 of 'band' multiplied into 'power'
+inline void accumulateBandPower(const FrequencyTable& table, const Band& band, float* power)
+{
+    for( int s = 0; s < band.numSections; ++s )
+    {
+        auto p = toPolynomial(band.sections[s]);
+        int i = 0;
+
+#if SIMPLEEQ_BIQUAD_SSE2
+        const auto n0 = _mm_set1_ps(p.n0), n1 = _mm_set1_ps(p.n1), n2 = _mm_set1_ps(p.n2);
+        const auto d0 = _mm_set1_ps(p.d0), d1 = _mm_set1_ps(p.d1), d2 = _mm_set1_ps(p.d2);
+        const auto floor = _mm_set1_ps(powerFloor);
+
+        for( ; i + 4 <= table.size; i += 4 )
+        {
+            auto phi = _mm_loadu_ps(table.phi.data() + i);
+            auto num = _mm_add_ps(n0, _mm_mul_ps(phi, _mm_add_ps(n1, _mm_mul_ps(phi, n2))));
+            auto den = _mm_add_ps(d0, _mm_mul_ps(phi, _mm_add_ps(d1, _mm_mul_ps(phi, d2))));
+            auto acc = _mm_mul_ps(_mm_loadu_ps(power + i), _mm_div_ps(_mm_max_ps(num, floor), _mm_max_ps(den, floor)));
+            _mm_storeu_ps(power + i, _mm_max_ps(acc, floor));
+        }
+#endif
+
+        for( ; i < table.size; ++i )
+        {
+            auto phi = table.phi[i];
+            auto num = p.n0 + phi * (p.n1 + phi * p.n2);
+            auto den = p.d0 + phi * (p.d1 + phi * p.d2);
+            power[i] = std::max(power[i] * (std::max(num, powerFloor) / std::max(den, powerFloor)), powerFloor);
+        }
+    }
+}
+
+inline void powerToDecibels(const float* power, float* decibels, int size, float floorDecibels)
+{
+    for( int i = 0; i < size; ++i )
+        decibels[i] = std::max(10.f * std::log10(power[i]), floorDecibels);
+}
+
+// phase and group delay of one section, scalar since it is optional and needs atan2
+inline void accumulatePhase(const FrequencyTable& table, const Biquad& q, float* phase, float* groupDelay)
+{
+    for( int i = 0; i < table.size; ++i )
+    {
+        auto c1 = table.cos1[i], s1 = table.sin1[i], c2 = table.cos2[i], s2 = table.sin2[i];
+
+        // N(w) = b0 + b1 e^-jw + b2 e^-2jw, D(w) = 1 + a1 e^-jw + a2 e^-2jw
+        auto nr = q.b0 + q.b1 * c1 + q.b2 * c2, ni = -(q.b1 * s1 + q.b2 * s2);
+        auto dr = 1.f + q.a1 * c1 + q.a2 * c2, di = -(q.a1 * s1 + q.a2 * s2);
+
+        if( phase != nullptr )
+            phase[i] += std::atan2(ni, nr) - std::atan2(di, dr);
+
+        if( groupDelay != nullptr )
+        {
+            // tau = Re( sum k c_k e^-jkw / sum c_k e^-jkw ) for the numerator minus the same for the denominator
+            auto tr = q.b1 * c1 + 2.f * q.b2 * c2, ti = -(q.b1 * s1 + 2.f * q.b2 * s2);
+            auto ur = q.a1 * c1 + 2.f * q.a2 * c2, ui = -(q.a1 * s1 + 2.f * q.a2 * s2);
+            auto nn = std::max(nr * nr + ni * ni, powerFloor);
+            auto dd = std::max(dr * dr + di * di, powerFloor);
+            groupDelay[i] += (tr * nr + ti * ni) / nn - (ur * dr + ui * di) / dd;
+        }
+    }
+}
+} // namespace detail
+
+/**
+ Magnitude in dB of the whole cascade of 'bands' for every frequency of the table,
+ plus the optional per band curves, phase and group delay from the same pass.
+ 'scratch' avoids allocating, it is resized when needed.
+ */
+inline void evaluate(const FrequencyTable& table,
+                     const Band* bands,
+                     int numBands,
+                     float* decibels,
+                     std::vector<float>& scratch,
+                     ExtraOutputs extra = {},
+                     float floorDecibels = -100.f)
+{
+    const auto size = table.size;
+    scratch.assign(size * 2, 1.f);
+    auto* total = scratch.data();
+    auto* bandPower = scratch.data() + size;
+
+    if( extra.phase != nullptr )
+        std::fill(extra.phase, extra.phase + size, 0.f);
+    if( extra.groupDelay != nullptr )
+        std::fill(extra.groupDelay, extra.groupDelay + size, 0.f);
+
+    for( int b = 0; b < numBands; ++b )
+    {
+        auto* bandDecibels = extra.bandDecibels != nullptr ? extra.bandDecibels[b] : nullptr;
+
+        if( bandDecibels != nullptr )
+        {
+            std::fill(bandPower, bandPower + size, 1.f);
+            detail::accumulateBandPower(table, bands[b], bandPower);
+            detail::powerToDecibels(bandPower, bandDecibels, size, floorDecibels);
+
+            for( int i = 0; i < size; ++i )
+                total[i] = std::max(total[i] * bandPower[i], detail::powerFloor);
+        }
+        else
+        {
+            detail::accumulateBandPower(table, bands[b], total);
+        }
+
+        if( extra.phase != nullptr || extra.groupDelay != nullptr )
+            for( int s = 0; s < bands[b].numSections; ++s )
+                detail::accumulatePhase(table, bands[b].sections[s], extra.phase, extra.groupDelay);
+    }
+
+    detail::powerToDecibels(total, decibels, size, floorDecibels);
+}
+} // namespace BiquadResponse
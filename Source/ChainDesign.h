@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    Allocation free versions of the filter designs the chain uses, so the
+    coefficients can be computed on the audio thread or for every step of a
+    morph. Same formulas as juce::dsp::IIR::Coefficients::makePeakFilter,
+    makeHighPass / makeLowPass and FilterDesign's HighOrderButterworthMethod,
+    computed in double and stored normalised (a0 == 1), plus a magnitude
+    matched alternative for the peak.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include "BiquadResponse.h"
+
+namespace ChainDesign
+{
+constexpr double pi = 3.14159265358979323846;
+
+inline BiquadResponse::Biquad normalise(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    auto inv = 1.0 / a0;
+    return { float(b0 * inv), float(b1 * inv), float(b2 * inv), float(a1 * inv), float(a2 * inv) };
+}
+
+// RBJ peaking eq, like makePeakFilter(sampleRate, frequency, Q, gainFactor)
+inline BiquadResponse::Biquad peak(double sampleRate, double frequency, double Q, double gainFactor)
+{
+    auto A = std::sqrt(std::max(0.0, gainFactor));
+    auto omega = 2.0 * pi * std::max(frequency, 2.0) / sampleRate;
+    auto alpha = std::sin(omega) / (Q * 2.0);
+    auto c2 = -2.0 * std::cos(omega);
+    auto alphaTimesA = alpha * A;
+    auto alphaOverA = alpha / A;
+
+    return normalise(1.0 + alphaTimesA, c2, 1.0 - alphaTimesA, 1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+}
+
+/**
+ Magnitude matched peaking eq, after M. Vicanek, "Matched Second Order Digital Filters" (2016).
+ Same analog prototype as peak() : H(s) = (s^2 + s A / Q + 1) / (s^2 + s / (A Q) + 1), A^2 = gainFactor.
+ The poles are the exact (impulse invariant) ones of the prototype and the zeros are solved so the
+ magnitude matches it at DC and at the centre frequency, with a zero slope at the centre so the bell
+ still peaks there. Nyquist is not matched, it gets whatever these leave : a 16 kHz +12 dB bell at
+ 48 kHz reads 8.7 dB there against 6.9 dB for the prototype, where the bilinear design pins it to
+ 0 dB and squeezes the upper half of the bell. Same cost per sample as peak().
+ B1 is clamped at 0 so the numerator stays real, which gives up the centre match. It only happens
+ with the centre at or above Nyquist (e.g. a wide 17 kHz boost at 22.05 kHz), never for 20 Hz - 20 kHz
+ at 44.1 kHz and up.
+ */
+inline BiquadResponse::Biquad peakMatched(double sampleRate, double frequency, double Q, double gainFactor)
+{
+    auto G = std::max(0.0, gainFactor);
+    auto A = std::sqrt(G);
+    auto omega = 2.0 * pi * std::max(frequency, 2.0) / sampleRate;
+
+    // poles of the prototype, its denominator quality is A * Q
+    auto q = 1.0 / (2.0 * Q * A);
+    auto decay = std::exp(-q * omega);
+    auto a1 = q <= 1.0 ? -2.0 * decay * std::cos(std::sqrt(1.0 - q * q) * omega)
+                       : -2.0 * decay * std::cosh(std::sqrt(q * q - 1.0) * omega);
+    auto a2 = decay * decay;
+
+    auto phi1 = std::sin(omega / 2.0);
+    phi1 *= phi1;
+    auto phi0 = 1.0 - phi1;
+    auto phi2 = 4.0 * phi0 * phi1;
+
+    auto A0 = (1.0 + a1 + a2) * (1.0 + a1 + a2);
+    auto A1 = (1.0 - a1 + a2) * (1.0 - a1 + a2);
+    auto A2 = -4.0 * a2;
+
+    auto R1 = (A0 * phi0 + A1 * phi1 + A2 * phi2) * G * G;
+    auto R2 = (-A0 + A1 + 4.0 * (phi0 - phi1) * A2) * G * G;
+
+    auto B0 = A0;
+    auto B2 = (R1 - R2 * phi1 - B0) / (4.0 * phi1 * phi1);
+    auto B1 = std::max(0.0, R2 + B0 + 4.0 * (phi1 - phi0) * B2);
+
+    auto W = 0.5 * (std::sqrt(B0) + std::sqrt(B1));
+    auto b0 = 0.5 * (W + std::sqrt(std::max(0.0, W * W + B2)));
+    auto b1 = 0.5 * (std::sqrt(B0) - std::sqrt(B1));
+    auto b2 = -B2 / (4.0 * b0);
+
+    return { float(b0), float(b1), float(b2), float(a1), float(a2) };
+}
+
+// bilinear 2nd order sections, like makeHighPass / makeLowPass(sampleRate, frequency, Q)
+inline BiquadResponse::Biquad highPass(double sampleRate, double frequency, double Q)
+{
+    auto n = std::tan(pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / Q;
+    auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    return { float(c1), float(-c1 * 2.0), float(c1),
+             float(c1 * 2.0 * (nSquared - 1.0)), float(c1 * (1.0 - invQ * n + nSquared)) };
+}
+
+inline BiquadResponse::Biquad lowPass(double sampleRate, double frequency, double Q)
+{
+    auto n = 1.0 / std::tan(pi * frequency / sampleRate);
+    auto nSquared = n * n;
+    auto invQ = 1.0 / Q;
+    auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    return { float(c1), float(c1 * 2.0), float(c1),
+             float(c1 * 2.0 * (1.0 - nSquared)), float(c1 * (1.0 - invQ * n + nSquared)) };
+}
+
+/**
+ Butterworth cascade of an even 'order' (the chain only uses 2, 4, 6 and 8), one section
+ per pair of poles, same Q order as designIIR...HighOrderButterworthMethod.
+ Writes order / 2 sections into 'sections' and returns how many.
+ */
+inline int butterworthHighPass(double sampleRate, double frequency, int order, BiquadResponse::Biquad* sections)
+{
+    auto numSections = order / 2;
+    for( int i = 0; i < numSections; ++i )
+        sections[i] = highPass(sampleRate, frequency, 1.0 / (2.0 * std::cos((2.0 * i + 1.0) * pi / (order * 2.0))));
+    return numSections;
+}
+
+inline int butterworthLowPass(double sampleRate, double frequency, int order, BiquadResponse::Biquad* sections)
+{
+    auto numSections = order / 2;
+    for( int i = 0; i < numSections; ++i )
+        sections[i] = lowPass(sampleRate, frequency, 1.0 / (2.0 * std::cos((2.0 * i + 1.0) * pi / (order * 2.0))));
+    return numSections;
+}
+} // namespace ChainDesign
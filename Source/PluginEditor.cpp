@@ -21,6 +21,7 @@ void LookAndFeel::drawRotarySlider(juce::Graphics &g,
                                    juce::Slider &slider)
 {
   using namespace juce;
+  PaintProfiler::Scope profile(PaintProfiler::DrawRotarySlider);
   auto bounds = Rectangle<float>(x, y, width, height);
 auto enabled = slider.isEnabled();
 
@@ -120,6 +121,7 @@ void LookAndFeel::drawToggleButton(juce::Graphics &g,
 void RotarySliderWithLabels::paint(juce::Graphics &g)
 {
   using namespace juce;
+  PaintProfiler::Scope profile(PaintProfiler::RotarySliderPaint);
   auto startAng = degreesToRadians(180.f + 45.f);
   auto endAng = degreesToRadians(180.f - 45.f) + MathConstants<float>::twoPi;
   auto range = getRange();
@@ -203,9 +205,7 @@ juce::String RotarySliderWithLabels::getDisplayString() const
   return str;
 }
 //=================================================================================
-ResponseCurveComponent::ResponseCurveComponent(SimpleEqAudioProcessor &p) : audioProcessor(p),
-                                                                            leftPathProducer(audioProcessor.leftChannelFifo),
-                                                                            rightPathProducer(audioProcessor.rightChannelFifo)
+ResponseCurveComponent::ResponseCurveComponent(SimpleEqAudioProcessor &p) : audioProcessor(p)
 // leftChannelFifo(&audioProcessor.leftChannelFifo)
 {
   const auto &params = audioProcessor.getParameters();
@@ -214,13 +214,19 @@ ResponseCurveComponent::ResponseCurveComponent(SimpleEqAudioProcessor &p) : audi
     param->addListener(this);
   }
 
-  updateChain();
+  // the analyzer follows the parameter, whatever sets it (the button, automation, a preset), see renderTick()
+  analyzerEnabledParameter = audioProcessor.apvts.getRawParameterValue("Analyzer Enabled");
+  shouldShowFFTAnalisis = analyzerEnabledParameter->load() > 0.5f;
+
+  // the processor may not have processed a block yet (stopped transport), make sure there is a snapshot
+  audioProcessor.refreshCoefficientSnapshot();
   // dont forget it otherwise s actiove pas
-  startTimerHz(60);
+  renderScheduler->addClient(this);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+  renderScheduler->removeClient(this);
   const auto &params = audioProcessor.getParameters();
   for (auto param : params)
   {
@@ -232,151 +238,266 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
   parametersChanged.set(true);
 }
 
-//===========================Lets move from timer calleback in here
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+void PathProducer::setConsuming(bool shouldConsume)
 {
-  // FFT START HERE SEEMS HARDDDD
-  juce::AudioBuffer<float> tempIncomingBuffer;
+  if (shouldConsume == consuming)
+    return;
 
-  while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
+  consuming = shouldConsume;
+  if (!consuming)
   {
-    if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))
-    {
-      auto size = tempIncomingBuffer.getNumSamples();
-      // On commence a ecrire dans monobuffer en 0, on copy ce qu'il y a depuis size, puis on copie tout le reste - size car on va pas plus loin
-      juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-                                        monoBuffer.getReadPointer(0, size),
-                                        monoBuffer.getNumSamples() - size);
-
-      // Puis on colle a la fin de notre monoBuffer ce qui vient du tempIncomingBUffer
-      juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                                        tempIncomingBuffer.getReadPointer(0, 0),
-                                        size);
-
-      leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
-    }
+    leftChannelFifo->detachConsumer();
+    rightChannelFifo->detachConsumer();
+    return;
   }
 
+  // the fifos come back empty, our own history is just as old so it goes too
+  leftChannelFifo->attachConsumer();
+  rightChannelFifo->attachConsumer();
+  for (auto *history : {&leftHistory, &rightHistory, &leftLowBandHistory, &rightLowBandHistory})
+    history->clear();
+  lowBandSampleRate = 0.0;
+}
+
+void PathProducer::prepareLowBand(double sampleRate)
+{
+  lowBandSampleRate = sampleRate;
+  leftDecimator.prepare(sampleRate);
+  rightDecimator.prepare(sampleRate);
+  leftLowBandHistory.clear();
+  rightLowBandHistory.clear();
+  lowBandSamplesSinceLastFFT = 0;
+  // the floor until the first low band frame
+  lowBandGenerator.clearFFTData(-48.f);
+}
+
+size_t PathProducer::getAllocatedBytes() const
+{
+  auto bytes = leftIncomingBuffer.getNumSamples() * sizeof(float) + rightIncomingBuffer.getNumSamples() * sizeof(float);
+  for (auto *history : {&leftHistory, &rightHistory, &leftLowBandHistory, &rightLowBandHistory})
+    bytes += history->getAllocatedBytes();
+  for (auto &generator : pathProducers)
+    bytes += generator.getAllocatedBytes();
+  bytes += fftDataGenerator.getAllocatedBytes() + lowBandGenerator.getAllocatedBytes();
+  bytes += decimatedScratch.capacity() * sizeof(float);
+  return bytes + spectrogram.getAllocatedBytes();
+}
+
+bool PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+{
+  PaintProfiler::Scope profile(PaintProfiler::PathProducerProcess);
+  TRACE_SCOPE("PathProducer::process");
+  bool newPath = false;
+
+  // FFT START HERE SEEMS HARDDDD
+  // the incoming buffers are members : once they have the block size, pulling into them is a plain copy
+
+  if (multiResolution && sampleRate != lowBandSampleRate)
+    prepareLowBand(sampleRate);
+
   /**
    *  if there are FFt data to pull
    * if we can pull a buffer then generate a path
    */
-  const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
+  const auto fftSize = fftDataGenerator.getFFTSize();
 
   /*
   48000/2048 = 23 hz : this is the binwidth
   */
   const auto binWidth = sampleRate / (double)fftSize;
 
-  while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+  const auto lowBandFFTSize = lowBandGenerator.getFFTSize();
+  const auto lowBandBinWidth = sampleRate / AnalyzerDecimator::factor / (double)lowBandFFTSize;
+  const auto crossover = AnalyzerDecimator::passband * sampleRate / AnalyzerDecimator::factor;
+
+  if (spectrogramEnabled && binWidth > 0.0)
+    spectrogram.prepare(juce::roundToInt(fftBounds.getHeight()), fftSize, (float)binWidth);
+
+  bool newFrame = false;
+
+  // both fifos are fed by the same processBlock so they count the same samples : we read the same position
+  // from both (the furthest one when one of them skipped ahead), one transform per pair of buffers
+  while (true)
   {
-    std::vector<float> fftData;
-    if (leftChannelFFTDataGenerator.getFFTData(fftData))
+    auto position = juce::jmax(leftChannelFifo->getNextReadPosition(), rightChannelFifo->getNextReadPosition());
+    if (!leftChannelFifo->getAudioBuffer(leftIncomingBuffer, position) ||
+        !rightChannelFifo->getAudioBuffer(rightIncomingBuffer, position))
+      break;
+
+    auto size = leftIncomingBuffer.getNumSamples();
+    leftHistory.push(leftIncomingBuffer.getReadPointer(0), size);
+    rightHistory.push(rightIncomingBuffer.getReadPointer(0), size);
+
+    fftDataGenerator.produceFFTDataForRendering(leftHistory, rightHistory, -48.f);
+    newFrame = true;
+
+    // the generator only keeps the latest spectrum, the spectrogram takes each one as it comes
+    if (spectrogramEnabled)
+      spectrogram.pushSpectrum(fftDataGenerator.getFFTData(LeftTrace), fftDataGenerator.getFFTData(RightTrace), -48.f);
+
+    if (multiResolution)
     {
-      pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+      // both decimators run in phase so they always output the same number of samples
+      if ((int)decimatedScratch.size() < size)
+        decimatedScratch.resize(size);
+
+      auto numDecimated = leftDecimator.process(leftIncomingBuffer.getReadPointer(0), size, decimatedScratch.data());
+      leftLowBandHistory.push(decimatedScratch.data(), numDecimated);
+
+      numDecimated = rightDecimator.process(rightIncomingBuffer.getReadPointer(0), size, decimatedScratch.data());
+      rightLowBandHistory.push(decimatedScratch.data(), numDecimated);
+
+      // the low band moves 'factor' times slower, an eighth of its window as hop is plenty
+      lowBandSamplesSinceLastFFT += numDecimated;
+      if (lowBandSamplesSinceLastFFT >= lowBandGenerator.getFFTSize() / 8)
+      {
+        lowBandGenerator.produceFFTDataForRendering(leftLowBandHistory, rightLowBandHistory, -48.f);
+        lowBandSamplesSinceLastFFT = 0;
+      }
     }
   }
 
-  /**
-   * while there are path that can be pull, pull as many as we can
-   * we only display the most recent one
-   */
-  while (pathProducer.getNumPathsAvailable())
+  // only the latest frame is drawn, so the paths are built once whatever the number of frames pulled
+  if (newFrame)
   {
-    pathProducer.getPath(leftChannelFFTPath);
+    auto numTraces = fftDataGenerator.isMidSideEnabled() ? NumAnalyzerTraces : MidTrace;
+    for (int trace = 0; trace < numTraces; ++trace)
+    {
+      auto analyzerTrace = static_cast<AnalyzerTrace>(trace);
+      auto &fftData = fftDataGenerator.getFFTData(analyzerTrace);
+
+      if (multiResolution)
+        pathProducers[trace].generatePath(fftData, fftSize, binWidth,
+                                          &lowBandGenerator.getFFTData(analyzerTrace), lowBandFFTSize, lowBandBinWidth, crossover,
+                                          fftBounds, -48.f);
+      else
+        pathProducers[trace].generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+    }
   }
-}
-void ResponseCurveComponent::timerCallback()
-{
-  if(shouldShowFFTAnalisis){
-      auto fftBounds = getAnalysisArea().toFloat();
-  auto sampleRate = audioProcessor.getSampleRate();
-  leftPathProducer.process(fftBounds, sampleRate);
-  rightPathProducer.process(fftBounds, sampleRate);
+
+  // the generators keep their most recent path, we only need to know if one of them changed
+  for (int trace = 0; trace < NumAnalyzerTraces; ++trace)
+  {
+    newPath |= pathProducers[trace].pullNewPath();
   }
 
+  return newPath;
+}
+void RenderScheduler::timerCallback()
+{
+  ++tickCount;
+  auto start = juce::Time::getMillisecondCounterHiRes();
+  int numRepaints = 0;
 
-  if (parametersChanged.compareAndSetBool(false, true))
+  for (auto *client : clients)
   {
-    // update the monochain
-    updateChain();
-    // set a repaint
+    auto divider = juce::jmax(1, client->getTickDivider());
+    if (tickCount % (juce::uint64)divider == 0 && client->renderTick())
+      ++numRepaints;
   }
-  repaint();
+
+  auto elapsed = juce::Time::getMillisecondCounterHiRes() - start;
+  stats.numClients = clients.size();
+  stats.averageTickMs += smoothing * (elapsed - stats.averageTickMs);
+  stats.repaintsPerSecond += smoothing * (numRepaints * frameRateHz - stats.repaintsPerSecond);
 }
 
-void ResponseCurveComponent::updateChain()
+int ResponseCurveComponent::getTickDivider() const
 {
-  auto chainSettings = getChainSettings(audioProcessor.apvts);
+  // hidden or minimised : only keep the curve up to date, a few times per second
+  if (!isShowing())
+    return RenderScheduler::frameRateHz / 4;
+
+  // without the analyzer only the parameters can change, half rate is enough
+  if (!shouldShowFFTAnalisis)
+    return 2;
+
+  return 1;
+}
+
+bool ResponseCurveComponent::renderTick()
+{
+  bool newAnalyzerFrame = false, curveChanged = false;
+
+  auto analyzerEnabled = analyzerEnabledParameter->load() > 0.5f;
+  if (analyzerEnabled != shouldShowFFTAnalisis)
+    toggleAnalysisEnablement(analyzerEnabled);
+
+  // the FFTs, fifos and histories are only built once the analyzer is enabled and we have been on screen
+  if (shouldShowFFTAnalisis && hasBeenPainted && pathProducer == nullptr)
+    pathProducer = std::make_unique<PathProducer>(audioProcessor.leftChannelFifo, audioProcessor.rightChannelFifo);
+
+  if(shouldShowFFTAnalisis && pathProducer != nullptr){
+      auto fftBounds = getAnalysisArea().toFloat();
+  auto sampleRate = audioProcessor.getSampleRate();
+  auto resolution = static_cast<int>(audioProcessor.apvts.getRawParameterValue("Analyzer Resolution")->load());
+  pathProducer->setFFTOrder(static_cast<FFTOrder>(minFFTOrder + resolution));
+  pathProducer->setMultiResolution(audioProcessor.apvts.getRawParameterValue("Analyzer Mode")->load() > 0.5f);
+  pathProducer->setSpectrogramEnabled(audioProcessor.apvts.getRawParameterValue("Analyzer View")->load() > 0.5f);
+  pathProducer->setMidSideEnabled(audioProcessor.apvts.getRawParameterValue("Analyzer Channels")->load() > 0.5f);
+  newAnalyzerFrame = pathProducer->process(fftBounds, sampleRate);
+  }
+
+  // the audio thread publishes on its own, we only ask for a snapshot when it may not be running
+  if (parametersChanged.compareAndSetBool(false, true))
+    audioProcessor.refreshCoefficientSnapshot();
 
-  monoChain.setBypassed<ChainPosition::HighCut>(chainSettings.highCutBypassed);
-  monoChain.setBypassed<ChainPosition::LowCut>(chainSettings.lowCutBypassed);
-  monoChain.setBypassed<ChainPosition::Peak>(chainSettings.peakBypassed);
+  // new settings or a new sample rate : the processor designed them, we just draw them
+  auto version = audioProcessor.getCoefficientSnapshotVersion();
+  if (version != drawnSnapshotVersion)
+  {
+    snapshot = audioProcessor.getCoefficientSnapshot();
+    drawnSnapshotVersion = snapshot.version;
+    updateResponseCurve();
+    curveChanged = true;
+  }
 
-  auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-  updateCoefficients(monoChain.get<ChainPosition::Peak>().coefficients, peakCoefficients);
+  // nothing new, nothing to draw, and only the area of the layers that changed
+  if (curveChanged)
+    repaint(getRenderArea().expanded(2));
+  else if (newAnalyzerFrame)
+    repaint(getAnalysisArea());
 
-  auto lowCutCoefficient = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-  auto highCutCoefficient = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-  updateCutFilter(monoChain.get<ChainPosition::LowCut>(), lowCutCoefficient, chainSettings.lowCutSlope);
-  updateCutFilter(monoChain.get<ChainPosition::HighCut>(), highCutCoefficient, chainSettings.highCutSlope);
+  return curveChanged || newAnalyzerFrame;
 }
 
-void ResponseCurveComponent::paint(juce::Graphics &g)
+/**
+ * The magnitudes and the stroked curve only depend on the snapshot and the size,
+ * so they are computed here once and paint() just fills the cached outline.
+ */
+void ResponseCurveComponent::updateResponseCurve()
 {
   using namespace juce;
-  // (Our component is opaque, so we must completely fill the background with a solid colour)
-  // g.fillAll(Colours::black);
-
-  g.drawImage(background, getLocalBounds().toFloat());
   auto responseArea = getAnalysisArea();
   auto w = responseArea.getWidth();
-  auto &lowcut = monoChain.get<ChainPosition::LowCut>();
-  auto &peak = monoChain.get<ChainPosition::Peak>();
-  auto &highcut = monoChain.get<ChainPosition::HighCut>();
 
-  // COurbe drawng
-  auto sampleRate = audioProcessor.getSampleRate();
-  std::vector<double> mags;
-  mags.resize(w);
-  for (int i = 0; i < w; i++)
-  {
-    double mag = 1.f;
-    auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-    if (!monoChain.isBypassed<ChainPosition::Peak>())
-      mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+  responseCurve.clear();
+  strokedResponseCurve.clear();
+  if (w <= 0 || snapshot.sampleRate <= 0.0)
+    return;
 
-    if (!monoChain.isBypassed<ChainPosition::LowCut>())
-    {
-      if (!lowcut.isBypassed<0>())
-        mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-      if (!lowcut.isBypassed<1>())
-        mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-      if (!lowcut.isBypassed<2>())
-        mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-      if (!lowcut.isBypassed<3>())
-        mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-    }
+  // COurbe drawng : the frequencies only change with the width and the sample rate
+  auto sampleRate = snapshot.sampleRate;
+  if (!frequencyTable.matches(w, sampleRate))
+    frequencyTable.build(w, sampleRate);
 
-    if (!monoChain.isBypassed<ChainPosition::HighCut>())
-    {
+  // gather the active sections of each band, bypassed ones are simply left out
+  const auto &coefficients = snapshot.coefficients;
+  std::array<BiquadResponse::Band, 3> bands;
+  int numBands = 0;
 
-      if (!highcut.isBypassed<0>())
-        mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+  if (!coefficients.lowCutBypassed)
+    bands[numBands++] = {coefficients.lowCut.data(), coefficients.lowCutStages};
 
-      if (!highcut.isBypassed<1>())
-        mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+  if (!coefficients.peakBypassed)
+    bands[numBands++] = {&coefficients.peak, 1};
 
-      if (!highcut.isBypassed<2>())
-        mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+  if (!coefficients.highCutBypassed)
+    bands[numBands++] = {coefficients.highCut.data(), coefficients.highCutStages};
 
-      if (!highcut.isBypassed<3>())
-        mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-    }
-    mags[i] = Decibels::gainToDecibels(mag);
-  }
+  mags.resize(w);
+  BiquadResponse::evaluate(frequencyTable, bands.data(), numBands, mags.data(), responseScratch);
 
-  Path responseCurve;
   const double outputMin = responseArea.getBottom();
   const double outputMax = responseArea.getY();
   auto map = [outputMin, outputMax](double input)
@@ -392,28 +513,102 @@ void ResponseCurveComponent::paint(juce::Graphics &g)
     responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
   }
 
-  if(shouldShowFFTAnalisis){
- auto leftChannelFFTPath = leftPathProducer.getPath();
-  auto rightChannelFFTPath = rightPathProducer.getPath();
+  PathStrokeType(2.f).createStrokedPath(strokedResponseCurve, responseCurve);
+  curveLayerDirty = true;
+}
+
+/**
+ * Three layers : the static grid (background), the analyzer traces drawn every frame,
+ * and the border + response curve cached in curveLayer until the curve changes.
+ */
+void ResponseCurveComponent::paint(juce::Graphics &g)
+{
+  using namespace juce;
+  PaintProfiler::Scope profile(PaintProfiler::ResponseCurvePaint);
+  TRACE_SCOPE("ResponseCurveComponent::paint");
+  auto paintStart = Time::getMillisecondCounterHiRes();
+  // (Our component is opaque, so we must completely fill the background with a solid colour)
+  // g.fillAll(Colours::black);
+
+  if (background.isNull())
+    renderBackground();
+  g.drawImageAt(background, 0, 0);
+  hasBeenPainted = true;
+  auto responseArea = getAnalysisArea();
+
+  if(shouldShowFFTAnalisis && pathProducer != nullptr){
+  Graphics::ScopedSaveState saveState(g);
+  // analyzer only repaints are limited to the analysis area, so the traces must stay in it
+  g.reduceClipRegion(responseArea);
+
+  // under the traces, the grid stays visible through its quiet (transparent) part
+  if(pathProducer->isSpectrogramEnabled())
+    pathProducer->getSpectrogram().draw(g, responseArea);
 
-  leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()-10));
+  auto transform = AffineTransform::translation(responseArea.getX(), responseArea.getY()-10);
   g.setColour(Colours::skyblue);
-  g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
+  g.strokePath(pathProducer->getPath(LeftTrace), PathStrokeType(1.f), transform);
 
-  rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()-10));
   g.setColour(Colours::yellow);
-  g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
+  g.strokePath(pathProducer->getPath(RightTrace), PathStrokeType(1.f), transform);
+
+  if(pathProducer->isMidSideEnabled()){
+  g.setColour(Colours::lightgreen);
+  g.strokePath(pathProducer->getPath(MidTrace), PathStrokeType(1.f), transform);
+
+  g.setColour(Colours::hotpink);
+  g.strokePath(pathProducer->getPath(SideTrace), PathStrokeType(1.f), transform);
+  }
+  }
+
+  // the layer is rendered at the physical resolution so the curve stays as sharp as a direct stroke
+  auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+  if (scale != curveLayerScale || curveLayer.isNull())
+  {
+    curveLayerScale = scale;
+    curveLayer = Image(Image::PixelFormat::ARGB,
+                       jmax(1, roundToInt(getWidth() * scale)),
+                       jmax(1, roundToInt(getHeight() * scale)),
+                       true);
+    curveLayerDirty = true;
   }
- 
+
+  if (curveLayerDirty)
+    renderCurveLayer();
+
+  g.drawImageTransformed(curveLayer, AffineTransform::scale(1.f / curveLayerScale));
+
+  auto paintTime = Time::getMillisecondCounterHiRes() - paintStart;
+  averagePaintMs += 0.05 * (paintTime - averagePaintMs);
+  renderScheduler->reportPaintTime(paintTime);
+}
+
+void ResponseCurveComponent::renderCurveLayer()
+{
+  using namespace juce;
+  curveLayerDirty = false;
+
+  curveLayer.clear(curveLayer.getBounds());
+  Graphics g(curveLayer);
+  g.addTransform(AffineTransform::scale(curveLayerScale));
 
   g.setColour(Colours::orange);
   g.drawRoundedRectangle(getRenderArea().toFloat(), 4.f, 1.f);
   g.setColour(Colours::white);
 
-  g.strokePath(responseCurve, PathStrokeType(2.f));
+  g.fillPath(strokedResponseCurve);
 }
 
 void ResponseCurveComponent::resized()
+{
+  using namespace juce;
+  // both layers are recreated by the next paint(), hosts often resize a few times before showing anything
+  curveLayer = Image();
+  background = Image();
+  updateResponseCurve();
+}
+
+void ResponseCurveComponent::renderBackground()
 {
   using namespace juce;
   background = Image(Image::PixelFormat::RGB, getWidth(), getHeight(), true);
@@ -535,6 +730,22 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea()
   return bounds;
 }
 
+void ResponseCurveComponent::addToMemoryReport(SimpleEqAudioProcessor::MemoryReport &report) const
+{
+  for (auto *image : {&background, &curveLayer})
+    if (image->isValid())
+      report.editorCurve += (size_t)image->getWidth() * (size_t)image->getHeight() * 4;
+  report.editorCurve += (mags.capacity() + responseScratch.capacity()) * sizeof(float);
+
+  if (pathProducer == nullptr)
+    return;
+
+  report.editorAnalyzer += sizeof(PathProducer) + pathProducer->getAllocatedBytes();
+  // they exist anyway while a PathProducer does, this doesn't create them
+  juce::SharedResourcePointer<FFTTables> tables;
+  report.sharedTables = tables->getAllocatedBytes();
+}
+
 //==============================================================================
 SimpleEqAudioProcessorEditor::SimpleEqAudioProcessorEditor(SimpleEqAudioProcessor &p)
     : AudioProcessorEditor(&p), audioProcessor(p),
@@ -589,10 +800,10 @@ SimpleEqAudioProcessorEditor::SimpleEqAudioProcessorEditor(SimpleEqAudioProcesso
     addAndMakeVisible(comp);
   }
 
-  peakBypassButton.setLookAndFeel(&lnf);
-  lowCutBypassButton.setLookAndFeel(&lnf);
-  highCutBypassButton.setLookAndFeel(&lnf);
-  analyzerEnabledButton.setLookAndFeel(&lnf);
+  peakBypassButton.setLookAndFeel(lnf);
+  lowCutBypassButton.setLookAndFeel(lnf);
+  highCutBypassButton.setLookAndFeel(lnf);
+  analyzerEnabledButton.setLookAndFeel(lnf);
 
 auto safePtr = juce::Component::SafePointer<SimpleEqAudioProcessorEditor>(this);
 //Lambda function
@@ -627,14 +838,8 @@ if (auto * comp = safePtr.getComponent()){
 };
 
 
-analyzerEnabledButton.onClick = [safePtr](){
-if (auto * comp = safePtr.getComponent()){
-  auto enabled = comp->analyzerEnabledButton.getToggleState();
-  comp->responseCurveComponent.toggleAnalysisEnablement(enabled);
-}
-
-};
   setSize(600, 480);
+  setDebugOverlayVisible(JUCE_DEBUG != 0);
 }
 
 SimpleEqAudioProcessorEditor::~SimpleEqAudioProcessorEditor()
@@ -654,6 +859,51 @@ void SimpleEqAudioProcessorEditor::paint(juce::Graphics &g)
   g.fillAll(Colours::black);
 }
 
+void SimpleEqAudioProcessorEditor::paintOverChildren(juce::Graphics &g)
+{
+  using namespace juce;
+  if (!debugOverlayVisible)
+    return;
+
+  auto stats = renderScheduler->getFrameStats();
+  String text;
+  text << "curve paint " << String(responseCurveComponent.getAveragePaintMs(), 2) << " ms | "
+       << "tick " << String(stats.averageTickMs, 2) << " ms | "
+       << String(stats.repaintsPerSecond, 0) << " fps | "
+       << stats.numClients << " editor(s)";
+
+  g.setColour(Colours::lightgrey);
+  g.setFont(10.f);
+  g.drawFittedText(text, getDebugOverlayArea(), Justification::centredRight, 1);
+}
+
+void SimpleEqAudioProcessorEditor::setDebugOverlayVisible(bool shouldBeVisible)
+{
+  debugOverlayVisible = shouldBeVisible;
+  if (debugOverlayVisible)
+    startTimerHz(4);
+  else
+    stopTimer();
+  repaint(getDebugOverlayArea());
+}
+
+void SimpleEqAudioProcessorEditor::addToMemoryReport(SimpleEqAudioProcessor::MemoryReport &report) const
+{
+  report.editorCurve += sizeof(*this);
+  responseCurveComponent.addToMemoryReport(report);
+}
+
+void SimpleEqAudioProcessorEditor::timerCallback()
+{
+  repaint(getDebugOverlayArea());
+}
+
+juce::Rectangle<int> SimpleEqAudioProcessorEditor::getDebugOverlayArea() const
+{
+  // top strip, next to the analyzer button, so refreshing it never touches the response curve
+  return getLocalBounds().removeFromTop(25).withTrimmedLeft(110).withTrimmedRight(5);
+}
+
 void SimpleEqAudioProcessorEditor::resized()
 {
   // This is generally where you'll want to lay out the positions of any
@@ -9,7 +9,10 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <numeric>
 #include "PluginProcessor.h"
+#include "SpectrumKernels.h"
+#include "BiquadResponse.h"
 //=====================================
 // Custom to create our sliders in the same way and not have to redo every thing again
 //==============FFT Analyzer
@@ -21,89 +24,254 @@ enum FFTOrder
     order8192 = 13
 };
 
+// orders exposed by the "Analyzer Resolution" parameter, in the same order as its choices
+constexpr FFTOrder minFFTOrder = FFTOrder::order2048;
+constexpr FFTOrder maxFFTOrder = FFTOrder::order8192;
+constexpr int maxFFTSize = 1 << maxFFTOrder;
+
+/**
+ FFT engines and windows of every FFTOrder, built once and shared by all the analyzers of the process.
+ FFT::perform is const so one engine can serve any number of generators.
+ */
+struct FFTTables
+{
+    FFTTables()
+    {
+        for( int i = 0; i < NumOrders; ++i )
+        {
+            auto order = minFFTOrder + i;
+            auto fftSize = 1 << order;
+
+            ffts[i] = std::make_unique<juce::dsp::FFT>(order);
+
+            windows[i].resize(fftSize);
+            juce::dsp::WindowingFunction<float>::fillWindowingTables(windows[i].data(),
+                                                                    (size_t)fftSize,
+                                                                    juce::dsp::WindowingFunction<float>::blackmanHarris);
+        }
+    }
+
+    const juce::dsp::FFT& getFFT(FFTOrder order) const { return *ffts[order - minFFTOrder]; }
+    const float* getWindow(FFTOrder order) const { return windows[order - minFFTOrder].data(); }
+
+    // the windows plus the twiddle tables of the ffts, roughly : juce doesn't expose their engine
+    size_t getAllocatedBytes() const
+    {
+        size_t bytes = 0;
+        for( auto& window : windows )
+            bytes += window.capacity() * (sizeof(float) + sizeof(juce::dsp::Complex<float>));
+        return bytes;
+    }
+private:
+    static constexpr int NumOrders = maxFFTOrder - minFFTOrder + 1;
+    std::array<std::unique_ptr<juce::dsp::FFT>, NumOrders> ffts;
+    std::array<std::vector<float>, NumOrders> windows;
+};
+
+enum AnalyzerTrace
+{
+    LeftTrace,
+    RightTrace,
+    MidTrace,
+    SideTrace,
+    NumAnalyzerTraces
+};
+
+/**
+ Circular history of one channel for the analyzer. Pushing a block is one or two copies of the
+ block itself, instead of shifting the whole history, and the last N samples are read back as
+ at most two contiguous segments.
+ */
+struct AnalyzerHistory
+{
+    struct Segments
+    {
+        const float* first;
+        int firstSize;
+        const float* second;
+        int secondSize;
+    };
+
+    void prepare(int numSamples)
+    {
+        data.assign((size_t)numSamples, 0.f);
+        writeIndex = 0;
+    }
+
+    void clear()
+    {
+        std::fill(data.begin(), data.end(), 0.f);
+        writeIndex = 0;
+    }
+
+    void push(const float* samples, int numSamples)
+    {
+        const auto size = getSize();
+        if( numSamples >= size )
+        {
+            samples += numSamples - size;
+            numSamples = size;
+        }
+
+        auto firstSize = juce::jmin(numSamples, size - writeIndex);
+        std::copy(samples, samples + firstSize, data.begin() + writeIndex);
+        std::copy(samples + firstSize, samples + numSamples, data.begin());
+        writeIndex = (writeIndex + numSamples) % size;
+    }
+
+    // the last numSamples samples, oldest first
+    Segments getLatest(int numSamples) const
+    {
+        const auto size = getSize();
+        jassert(numSamples <= size);
+        auto start = (writeIndex - numSamples + size) % size;
+        auto firstSize = juce::jmin(numSamples, size - start);
+        return { data.data() + start, firstSize, data.data(), numSamples - firstSize };
+    }
+
+    int getSize() const { return (int)data.size(); }
+    size_t getAllocatedBytes() const { return data.capacity() * sizeof(float); }
+private:
+    std::vector<float> data;
+    int writeIndex = 0;
+};
+
 template<typename BlockType>
 struct FFTDataGenerator
 {
     /**
-     produces the FFT data from an audio buffer.
+     produces the FFT data of both channels from a single complex transform.
+     left goes in the real part and right in the imaginary part, then the two
+     spectra are separated thanks to the conjugate symmetry of real signals :
+        L[k] = (Z[k] + conj(Z[N-k])) / 2
+        R[k] = (Z[k] - conj(Z[N-k])) / 2j
+     mid and side are linear combinations of L and R so they come without any extra transform.
      */
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    /**
+     only the latest spectrum of each trace is kept : it is what gets drawn, and whoever wants
+     every frame (the spectrogram) reads it right after produceFFTDataForRendering().
+     Nothing is allocated before prepare(), so a generator that never runs costs nothing.
+     */
+    void prepare()
     {
+        if( ! timeData.empty() )
+            return;
+
+        //everything is sized for the biggest order so changing order never allocates
+        timeData.resize(maxFFTSize);
+        freqData.resize(maxFFTSize);
+
+        for( auto& data : traceData )
+            data.resize(maxFFTSize / 2, 0);
+    }
+
+    /**
+     the transform uses the last getFFTSize() samples of the histories, so they can hold a longer one.
+     both histories must be pushed in lockstep so their segments line up.
+     */
+    void produceFFTDataForRendering(const AnalyzerHistory& leftData,
+                                    const AnalyzerHistory& rightData,
+                                    const float negativeInfinity)
+    {
+        TRACE_SCOPE("FFTDataGenerator::produceFFTDataForRendering");
         const auto fftSize = getFFTSize();
-        
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
-        
-        // first apply a windowing function to our data
-        window->multiplyWithWindowingTable (fftData.data(), fftSize);       // [1]
-        
-        // then render our FFT data..
-        forwardFFT->performFrequencyOnlyForwardTransform (fftData.data());  // [2]
-        
+        jassert(! timeData.empty());
+        jassert(leftData.getSize() >= fftSize && rightData.getSize() >= fftSize);
+        auto left = leftData.getLatest(fftSize);
+        auto right = rightData.getLatest(fftSize);
+        jassert(left.firstSize == right.firstSize);
+        auto* windowTable = tables->getWindow(order);
+
+        // window and interleave both channels in a single pass over each segment
+        for( int i = 0; i < left.firstSize; ++i )
+        {
+            auto w = windowTable[i];
+            timeData[i] = { left.first[i] * w, right.first[i] * w };
+        }
+
+        for( int i = 0; i < left.secondSize; ++i )
+        {
+            auto w = windowTable[left.firstSize + i];
+            timeData[left.firstSize + i] = { left.second[i] * w, right.second[i] * w };
+        }
+
+        tables->getFFT(order).perform(timeData.data(), freqData.data(), false);
+
         int numBins = (int)fftSize / 2;
-        
-        //normalize the fft values.
-        for( int i = 0; i < numBins; ++i )
+
+        //separate the spectra, we only need the power, the sqrt is folded into the log
+        for( int k = 0; k < numBins; ++k )
         {
-            auto v = fftData[i];
-//            fftData[i] /= (float) numBins;
-            if( !std::isinf(v) && !std::isnan(v) )
-            {
-                v /= float(numBins);
-            }
-            else
+            auto z = freqData[k];
+            auto zMirror = std::conj(freqData[(fftSize - k) & (fftSize - 1)]);
+
+            auto l = (z + zMirror) * 0.5f;
+            auto r = (z - zMirror) * std::complex<float>(0.f, -0.5f);
+
+            traceData[LeftTrace][k] = std::norm(l);
+            traceData[RightTrace][k] = std::norm(r);
+
+            if( midSideEnabled )
             {
-                v = 0.f;
+                traceData[MidTrace][k] = std::norm((l + r) * 0.5f);
+                traceData[SideTrace][k] = std::norm((l - r) * 0.5f);
             }
-            fftData[i] = v;
         }
-        
-        //convert them to decibels
-        for( int i = 0; i < numBins; ++i )
+
+        //normalize, sanitize and convert to decibels in one pass
+        for( int trace = 0; trace < NumAnalyzerTraces; ++trace )
         {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
+            if( trace >= MidTrace && ! midSideEnabled )
+                break;
+
+            SpectrumKernels::powerToDecibels(traceData[trace].data(), nullptr, nullptr, numBins, negativeInfinity);
         }
-        
-        fftDataFifo.push(fftData);
     }
     
     void changeOrder(FFTOrder newOrder)
     {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
-        //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
-        
+        //the tables are shared and the buffers already have the max size
+        jassert(minFFTOrder <= newOrder && newOrder <= maxFFTOrder);
         order = newOrder;
-        auto fftSize = getFFTSize();
-        
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
-        
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
-
-        fftDataFifo.prepare(fftData.size());
     }
+
+    void setMidSideEnabled(bool enabled) { midSideEnabled = enabled; }
+    bool isMidSideEnabled() const { return midSideEnabled; }
     //==============================================================================
     int getFFTSize() const { return 1 << order; }
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
+    FFTOrder getFFTOrder() const { return order; }
     //==============================================================================
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+    // the latest spectrum of 'trace' in decibels, overwritten by the next produceFFTDataForRendering()
+    const BlockType& getFFTData(AnalyzerTrace trace) const { return traceData[trace]; }
+    // e.g. to show a floor until the first frame
+    void clearFFTData(float value)
+    {
+        for( auto& data : traceData )
+            std::fill(data.begin(), data.end(), value);
+    }
+
+    size_t getAllocatedBytes() const
+    {
+        auto bytes = (timeData.capacity() + freqData.capacity()) * sizeof(juce::dsp::Complex<float>);
+        for( int trace = 0; trace < NumAnalyzerTraces; ++trace )
+            bytes += traceData[trace].capacity() * sizeof(float);
+        return bytes;
+    }
 private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
-    
-    Fifo<BlockType> fftDataFifo;
+    FFTOrder order = FFTOrder::order4096;
+    bool midSideEnabled = false;
+    juce::SharedResourcePointer<FFTTables> tables;
+    std::vector<juce::dsp::Complex<float>> timeData, freqData;
+    std::array<BlockType, NumAnalyzerTraces> traceData;
 };
 
 template<typename PathType>
 struct AnalyzerPathGenerator
 {
     /*
-     converts 'renderData[]' into a juce::Path
+     converts 'renderData[]' into a juce::Path, with one vertex per pixel column.
+     the bins of each column are found once in a table that is only rebuilt when the width,
+     the fft size or the bin width change, so a frame is just a gather over the bins.
      */
     void generatePath(const std::vector<float>& renderData,
                       juce::Rectangle<float> fftBounds,
@@ -111,14 +279,42 @@ struct AnalyzerPathGenerator
                       float binWidth,
                       float negativeInfinity)
     {
+        generatePath(renderData, fftSize, binWidth, nullptr, 0, 0.f, 0.f, fftBounds, negativeInfinity);
+    }
+
+    /*
+     same thing for the multi resolution analyzer : the columns below 'crossover' read
+     'lowBandData', the finer spectrum of the decimated signal, instead of 'renderData'.
+     */
+    void generatePath(const std::vector<float>& renderData,
+                      int fftSize,
+                      float binWidth,
+                      const std::vector<float>* lowBandData,
+                      int lowBandFFTSize,
+                      float lowBandBinWidth,
+                      float crossover,
+                      juce::Rectangle<float> fftBounds,
+                      float negativeInfinity)
+    {
+        TRACE_SCOPE("AnalyzerPathGenerator::generatePath");
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
-        auto width = fftBounds.getWidth();
+        auto width = juce::roundToInt(fftBounds.getWidth());
 
-        int numBins = (int)fftSize / 2;
+        BandLayout layout { (int)fftSize / 2, binWidth,
+                            lowBandData != nullptr ? (int)lowBandFFTSize / 2 : 0, lowBandBinWidth,
+                            lowBandData != nullptr ? crossover : 0.f };
+
+        if( width != mapWidth || ! (layout == mapLayout) )
+            buildBinMap(width, layout);
 
-        PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+        if( binMap.empty() )
+            return;
+
+        // built in place in the back path, its storage is kept from one frame to the next
+        auto& p = backPath;
+        p.clear();
+        p.preallocateSpace(3 * (int)binMap.size());
 
         auto map = [bottom, top, negativeInfinity](float v)
         {
@@ -127,49 +323,210 @@ struct AnalyzerPathGenerator
                               float(bottom+10),   top);
         };
 
-        auto y = map(renderData[0]);
+        for( int x = 0; x < (int)binMap.size(); ++x )
+        {
+            auto& column = binMap[x];
+            auto y = map(getColumnValue(column.lowBand ? *lowBandData : renderData, column));
+
+            if( x == 0 )
+                p.startNewSubPath(0, y);
+            else
+                p.lineTo(x, y);
+        }
+
+        frontPath.swapWithPath(backPath);
+        newPathAvailable = true;
+    }
+
+    // true once after every generatePath()
+    bool pullNewPath()
+    {
+        return std::exchange(newPathAvailable, false);
+    }
+
+    // the most recent complete path, only valid until the next generatePath()
+    const PathType& getPath() const { return frontPath; }
+
+    // juce::Path doesn't tell its size, a line segment is about three floats and there is one per column
+    size_t getAllocatedBytes() const
+    {
+        return binMap.capacity() * sizeof(ColumnBins) + 2 * (size_t)mapWidth * 3 * sizeof(float);
+    }
+private:
+    /*
+     bins [firstBin, lastBin) of a column, when there is less than 2 of them (low end)
+     the column is interpolated between firstBin and firstBin + 1 instead.
+     */
+    struct ColumnBins
+    {
+        int firstBin = 0;
+        int lastBin = 0;
+        float fraction = 0.f;
+        bool lowBand = false;
+    };
 
-//        jassert( !std::isnan(y) && !std::isinf(y) );
-        if( std::isnan(y) || std::isinf(y) )
-            y = bottom;
-        
-        p.startNewSubPath(0, y);
+    struct BandLayout
+    {
+        int numBins = 0;
+        float binWidth = 0.f;
+        int lowBandNumBins = 0;
+        float lowBandBinWidth = 0.f;
+        float crossover = 0.f;
 
-        const int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
+        bool operator==(const BandLayout& other) const
+        {
+            return numBins == other.numBins && binWidth == other.binWidth
+                && lowBandNumBins == other.lowBandNumBins && lowBandBinWidth == other.lowBandBinWidth
+                && crossover == other.crossover;
+        }
+    };
 
-        for( int binNum = 1; binNum < numBins; binNum += pathResolution )
+    void buildBinMap(int width, BandLayout layout)
+    {
+        mapWidth = width;
+        mapLayout = layout;
+
+        binMap.resize(juce::jmax(0, width));
+
+        auto frequency = [width](float column)
+        {
+            return juce::mapToLog10(column / float(width), 20.f, 20000.f);
+        };
+
+        for( int x = 0; x < width; ++x )
         {
-            y = map(renderData[binNum]);
+            auto& column = binMap[x];
+            column.lowBand = frequency(x + 0.5f) < layout.crossover;
+
+            auto numBins = column.lowBand ? layout.lowBandNumBins : layout.numBins;
+            auto binWidth = column.lowBand ? layout.lowBandBinWidth : layout.binWidth;
+
+            auto start = frequency(float(x)) / binWidth;
+            auto end = frequency(float(x + 1)) / binWidth;
 
-//            jassert( !std::isnan(y) && !std::isinf(y) );
+            column.firstBin = juce::jlimit(0, numBins - 1, (int)std::ceil(start));
+            column.lastBin = juce::jlimit(0, numBins, (int)std::ceil(end));
+            column.fraction = 0.f;
 
-            if( !std::isnan(y) && !std::isinf(y) )
+            if( column.lastBin - column.firstBin < 2 )
             {
-                auto binFreq = binNum * binWidth;
-                auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-                int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
+                auto centre = juce::jlimit(0.f, float(numBins - 1), frequency(x + 0.5f) / binWidth);
+                column.firstBin = juce::jmin((int)centre, numBins - 2);
+                column.lastBin = column.firstBin;
+                column.fraction = centre - float(column.firstBin);
             }
         }
+    }
+
+    // the loudest bin of the column, so a narrow peak isn't lost between two columns
+    float getColumnValue(const std::vector<float>& renderData, const ColumnBins& column) const
+    {
+        if( column.lastBin == column.firstBin )
+        {
+            auto a = renderData[column.firstBin];
+            auto b = renderData[column.firstBin + 1];
+            return a + column.fraction * (b - a);
+        }
 
-        pathFifo.push(p);
+        return *std::max_element(renderData.data() + column.firstBin, renderData.data() + column.lastBin);
     }
-    
 
-    int getNumPathsAvailable() const
+    std::vector<ColumnBins> binMap;
+    int mapWidth = 0;
+    BandLayout mapLayout;
+
+    PathType frontPath, backPath;
+    bool newPathAvailable = false;
+};
+
+
+/**
+ Timings of the expensive editor paths, filled while the editor benchmark runs (Benchmarks/Source/EditorBenchmark.h).
+ Disabled by default, a disabled Scope costs a branch. Message thread only.
+ */
+struct PaintProfiler
+{
+  enum Section
+  {
+    ResponseCurvePaint,
+    RotarySliderPaint,
+    DrawRotarySlider,
+    PathProducerProcess,
+    NumSections
+  };
+
+  static PaintProfiler &getInstance()
+  {
+    static PaintProfiler instance;
+    return instance;
+  }
+
+  struct Scope
+  {
+    explicit Scope(Section s) : section(s), active(getInstance().enabled)
     {
-        return pathFifo.getNumAvailableForReading();
+      if (active)
+        start = juce::Time::getMillisecondCounterHiRes();
     }
+    ~Scope()
+    {
+      if (active)
+        getInstance().samples[section].push_back(juce::Time::getMillisecondCounterHiRes() - start);
+    }
+    Section section;
+    bool active;
+    double start = 0.0;
+  };
 
-    bool getPath(PathType& path)
+  void setEnabled(bool shouldBeEnabled) { enabled = shouldBeEnabled; }
+  bool isEnabled() const { return enabled; }
+
+  void reset()
+  {
+    for (auto &s : samples)
+      s.clear();
+  }
+
+  static const char *getName(Section section)
+  {
+    static const char *names[NumSections] = {"ResponseCurveComponent::paint",
+                                             "RotarySliderWithLabels::paint",
+                                             "LookAndFeel::drawRotarySlider",
+                                             "PathProducer::process"};
+    return names[section];
+  }
+
+  // count, mean, min, median, 95th percentile and max in milliseconds
+  static juce::var summarise(std::vector<double> values)
+  {
+    auto *result = new juce::DynamicObject();
+    result->setProperty("count", (int)values.size());
+    if (!values.empty())
     {
-        return pathFifo.pull(path);
+      std::sort(values.begin(), values.end());
+      auto percentile = [&values](double p) { return values[juce::jmin(values.size() - 1, (size_t)(p * values.size()))]; };
+      result->setProperty("meanMs", std::accumulate(values.begin(), values.end(), 0.0) / values.size());
+      result->setProperty("minMs", values.front());
+      result->setProperty("p50Ms", percentile(0.5));
+      result->setProperty("p95Ms", percentile(0.95));
+      result->setProperty("maxMs", values.back());
     }
+    return juce::var(result);
+  }
+
+  juce::var toVar() const
+  {
+    auto *result = new juce::DynamicObject();
+    for (int i = 0; i < NumSections; ++i)
+      result->setProperty(getName(static_cast<Section>(i)), summarise(samples[i]));
+    return juce::var(result);
+  }
+
 private:
-    Fifo<PathType> pathFifo;
+  bool enabled = false;
+  std::array<std::vector<double>, NumSections> samples;
 };
 
-
 //================================================
 struct LookAndFeel : juce::LookAndFeel_V4
 {
@@ -194,7 +551,7 @@ struct RotarySliderWithLabels : juce::Slider
                                                                                             param(&rap),
                                                                                             suffix(unitsuffix)
   {
-    setLookAndFeel(&lnf);
+    setLookAndFeel(lnf);
   }
 
   ~RotarySliderWithLabels()
@@ -214,57 +571,400 @@ struct RotarySliderWithLabels : juce::Slider
   juce::String getDisplayString() const;
 
 private:
-  LookAndFeel lnf;
+  // stateless, so every slider of every editor shares the same one
+  juce::SharedResourcePointer<LookAndFeel> lnf;
   juce::RangedAudioParameter *param;
   juce::String suffix;
 };
 
 
+/**
+ Scrolling time/frequency view of the analyzer. Every spectrum from the FFTDataGenerator becomes
+ one column of a ring buffered image, so a frame costs one column write whatever the history length,
+ and drawing is two blits : the oldest part of the ring, then the newest.
+ Rows are log spaced like the response curve, each row takes the loudest of its bins.
+ */
+struct Spectrogram
+{
+    // columns kept, one per spectrum
+    static constexpr int historyLength = 256;
+
+    Spectrogram() { buildColourTable(); }
+
+    // the number of rows follows the drawn height, the row table follows the fft size and bin width.
+    // when any of them changes the old columns don't line up anymore and the history restarts
+    void prepare(int numRows, int fftSize, float binWidth)
+    {
+        numRows = juce::jmax(1, numRows);
+        if( image.isValid() && numRows == image.getHeight() && historyLength == image.getWidth()
+            && fftSize == tableFFTSize && binWidth == tableBinWidth )
+            return;
+
+        image = juce::Image(juce::Image::ARGB, historyLength, numRows, true);
+        writeColumn = 0;
+        buildRowTable(numRows, fftSize, binWidth);
+    }
+
+    // both channels go into the same column, loudest wins
+    void pushSpectrum(const std::vector<float>& left, const std::vector<float>& right, float negativeInfinity)
+    {
+        if( ! image.isValid() || rows.empty() )
+            return;
+
+        juce::Image::BitmapData column(image, writeColumn, 0, 1, image.getHeight(), juce::Image::BitmapData::writeOnly);
+
+        for( int y = 0; y < (int)rows.size(); ++y )
+        {
+            auto level = negativeInfinity;
+            for( int bin = rows[y].firstBin; bin < rows[y].lastBin; ++bin )
+                level = juce::jmax(level, left[bin], right[bin]);
+
+            auto index = juce::jlimit(0, ColourTableSize - 1,
+                                      juce::roundToInt(juce::jmap(level, negativeInfinity, 0.f, 0.f, float(ColourTableSize - 1))));
+            column.setPixelColour(0, y, colours[index]);
+        }
+
+        writeColumn = (writeColumn + 1) % image.getWidth();
+    }
+
+    // oldest columns on the left, newest on the right
+    void draw(juce::Graphics& g, juce::Rectangle<int> area) const
+    {
+        if( ! image.isValid() || area.isEmpty() )
+            return;
+
+        auto numColumns = image.getWidth();
+        auto numOldest = numColumns - writeColumn;
+        auto split = juce::roundToInt(area.getWidth() * (double)numOldest / numColumns);
+
+        juce::Graphics::ScopedSaveState saveState(g);
+        g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+        g.drawImage(image, area.getX(), area.getY(), split, area.getHeight(),
+                    writeColumn, 0, numOldest, image.getHeight());
+
+        if( writeColumn > 0 )
+            g.drawImage(image, area.getX() + split, area.getY(), area.getWidth() - split, area.getHeight(),
+                        0, 0, writeColumn, image.getHeight());
+    }
+
+    // nothing but the colour table until the first prepare()
+    size_t getAllocatedBytes() const
+    {
+        auto bytes = rows.capacity() * sizeof(RowBins);
+        if( image.isValid() )
+            bytes += (size_t)image.getWidth() * (size_t)image.getHeight() * 4;
+        return bytes;
+    }
+private:
+    struct RowBins
+    {
+        int firstBin = 0;
+        int lastBin = 1;
+    };
+
+    void buildRowTable(int numRows, int fftSize, float binWidth)
+    {
+        tableFFTSize = fftSize;
+        tableBinWidth = binWidth;
+        rows.resize(numRows);
+
+        auto numBins = fftSize / 2;
+        for( int y = 0; y < numRows; ++y )
+        {
+            // row 0 is the top, 20 kHz
+            auto high = juce::mapToLog10(1.f - float(y) / numRows, 20.f, 20000.f);
+            auto low = juce::mapToLog10(1.f - float(y + 1) / numRows, 20.f, 20000.f);
+
+            auto first = juce::jlimit(0, numBins - 1, (int)std::floor(low / binWidth));
+            auto last = juce::jlimit(first + 1, numBins, (int)std::ceil(high / binWidth));
+            rows[y] = { first, last };
+        }
+    }
+
+    void buildColourTable()
+    {
+        // transparent in the noise floor so the grid stays readable, then blue -> magenta -> orange -> yellow
+        juce::ColourGradient stops(juce::Colour(0x00000040), 0.f, 0.f, juce::Colours::yellow, 1.f, 0.f, false);
+        stops.addColour(0.35, juce::Colour(0xa02040c0));
+        stops.addColour(0.6, juce::Colour(0xd0c020a0));
+        stops.addColour(0.8, juce::Colour(0xf0ff9a01));
+
+        for( int i = 0; i < ColourTableSize; ++i )
+            colours[i] = stops.getColourAtPosition(double(i) / (ColourTableSize - 1));
+    }
+
+    static constexpr int ColourTableSize = 256;
+    std::array<juce::Colour, ColourTableSize> colours;
+    std::vector<RowBins> rows;
+    int tableFFTSize = 0;
+    float tableBinWidth = 0.f;
+
+    juce::Image image;
+    int writeColumn = 0;
+};
+
+/**
+ Low pass and keep one sample out of 'factor', feeds the low band of the multi resolution analyzer.
+ The elliptic anti aliasing filter keeps the aliases 60 dB down below 'passband' * the decimated sample rate.
+ */
+struct AnalyzerDecimator
+{
+  static constexpr int factor = 8;
+  static constexpr float passband = 0.4f;
+
+  void prepare(double sampleRate)
+  {
+    // the transition band is centred on the decimated nyquist : [passband, 1 - passband] * decimated rate,
+    // so everything that folds below 'passband' comes from the stopband
+    auto coefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderEllipticMethod(0.5f * float(sampleRate) / factor,
+                                                                                               sampleRate,
+                                                                                               (1.f - 2.f * passband) / factor,
+                                                                                               -0.1f,
+                                                                                               -60.f);
+    numSections = juce::jmin((int)coefficients.size(), maxSections);
+    for (int i = 0; i < numSections; ++i)
+    {
+      sections[i].coefficients = coefficients[i];
+      sections[i].reset();
+    }
+    phase = 0;
+  }
+
+  // returns the number of samples written in 'output'
+  int process(const float* input, int numSamples, float* output)
+  {
+    int numWritten = 0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+      auto sample = input[i];
+      for (int s = 0; s < numSections; ++s)
+        sample = sections[s].processSample(sample);
+
+      if (phase == 0)
+        output[numWritten++] = sample;
+
+      phase = (phase + 1) % factor;
+    }
+    return numWritten;
+  }
+
+private:
+  static constexpr int maxSections = 8;
+  std::array<juce::dsp::IIR::Filter<float>, maxSections> sections;
+  int numSections = 0;
+  int phase = 0;
+};
+
 struct PathProducer{
-  PathProducer(SingleChannelSampleFifo<SimpleEqAudioProcessor::BlockType>& scsf) : 
-  leftChannelFifo(&scsf)
+  PathProducer(SingleChannelSampleFifo<SimpleEqAudioProcessor::BlockType>& leftScsf,
+               SingleChannelSampleFifo<SimpleEqAudioProcessor::BlockType>& rightScsf) :
+  leftChannelFifo(&leftScsf),
+  rightChannelFifo(&rightScsf)
   {
-  leftChannelFFTDataGenerator.changeOrder(FFTOrder::order4096);
-  monoBuffer.setSize(1,leftChannelFFTDataGenerator.getFFTSize());
+  fftDataGenerator.prepare();
+  fftDataGenerator.changeOrder(FFTOrder::order4096);
+  // the history is kept at the max size so switching to a bigger order is immediately valid.
+  // everything a frame touches is sized here or in setMultiResolution(), process() never allocates
+  for (auto* history : { &leftHistory, &rightHistory })
+    history->prepare(maxFFTSize);
+  setConsuming(true);
   }
-  void process(juce::Rectangle<float> fftBounds,double sampleRate);
-  juce::Path getPath() const { return leftChannelFFTPath;}
+  ~PathProducer() { setConsuming(false); }
+
+  /**
+   While consuming, the processor feeds the analyzer fifos. Stop when nothing is drawn
+   so the audio thread skips the analyzer entirely, starting again begins from fresh audio.
+   */
+  void setConsuming(bool shouldConsume);
+  bool isConsuming() const { return consuming; }
+  // returns true when a new path is available
+  bool process(juce::Rectangle<float> fftBounds,double sampleRate);
+  void setFFTOrder(FFTOrder newOrder)
+  {
+    selectedOrder = newOrder;
+    updateOrders();
+  }
+  /**
+   multi resolution : the full band runs at 2048 points and the low band runs the selected
+   order on the signal decimated by AnalyzerDecimator::factor, which gives 'factor' times finer bins
+   below the crossover for less cpu than a single 4096 points transform.
+   */
+  void setMultiResolution(bool enabled)
+  {
+    if (enabled == multiResolution)
+      return;
+
+    multiResolution = enabled;
+    lowBandSampleRate = 0.0; // re-prepare the decimators and restart the low band history
+
+    // the low band only takes memory once it has been used
+    if (multiResolution && leftLowBandHistory.getSize() == 0)
+    {
+      lowBandGenerator.prepare();
+      leftLowBandHistory.prepare(maxFFTSize);
+      rightLowBandHistory.prepare(maxFFTSize);
+    }
+    updateOrders();
+  }
+  const juce::Path& getPath(AnalyzerTrace trace) const { return pathProducers[trace].getPath();}
+
+  // mid/side traces are derived from the same transform, they only cost the path generation
+  void setMidSideEnabled(bool enabled)
+  {
+    fftDataGenerator.setMidSideEnabled(enabled);
+    lowBandGenerator.setMidSideEnabled(enabled);
+  }
+  bool isMidSideEnabled() const { return fftDataGenerator.isMidSideEnabled(); }
+
+  // the spectrogram is fed from the same spectra as the traces, it costs no extra transform
+  void setSpectrogramEnabled(bool enabled) { spectrogramEnabled = enabled; }
+  bool isSpectrogramEnabled() const { return spectrogramEnabled; }
+  const Spectrogram& getSpectrogram() const { return spectrogram; }
+
+  // heap memory of everything above, the shared FFT tables excluded
+  size_t getAllocatedBytes() const;
   private:
+  void updateOrders()
+  {
+    auto fullBandOrder = multiResolution ? FFTOrder::order2048 : selectedOrder;
+    if (fullBandOrder != fftDataGenerator.getFFTOrder())
+      fftDataGenerator.changeOrder(fullBandOrder);
+    if (selectedOrder != lowBandGenerator.getFFTOrder())
+      lowBandGenerator.changeOrder(selectedOrder);
+  }
+  void prepareLowBand(double sampleRate);
+
    SingleChannelSampleFifo<SimpleEqAudioProcessor::BlockType>* leftChannelFifo;
-  juce::AudioBuffer<float> monoBuffer;
-  FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
-  AnalyzerPathGenerator<juce::Path> pathProducer; 
-  juce::Path leftChannelFFTPath;
+   SingleChannelSampleFifo<SimpleEqAudioProcessor::BlockType>* rightChannelFifo;
+  bool consuming = false;
+  juce::AudioBuffer<float> leftIncomingBuffer, rightIncomingBuffer;
+  AnalyzerHistory leftHistory, rightHistory;
+  FFTDataGenerator<std::vector<float>> fftDataGenerator;
+  std::array<AnalyzerPathGenerator<juce::Path>, NumAnalyzerTraces> pathProducers;
+  bool spectrogramEnabled = false;
+  Spectrogram spectrogram;
+
+  FFTOrder selectedOrder = FFTOrder::order4096;
+  bool multiResolution = false;
+  double lowBandSampleRate = 0.0;
+  AnalyzerDecimator leftDecimator, rightDecimator;
+  std::vector<float> decimatedScratch;
+  int lowBandSamplesSinceLastFFT = 0;
+  AnalyzerHistory leftLowBandHistory, rightLowBandHistory;
+  FFTDataGenerator<std::vector<float>> lowBandGenerator;
+};
+
+/**
+ One timer for every editor of the process instead of one per ResponseCurveComponent.
+ Clients are ticked at 'frameRateHz' divided by their own divider, they decide if they
+ need a repaint, and the scheduler keeps track of what the frames cost.
+ Shared through juce::SharedResourcePointer<RenderScheduler>, message thread only.
+ */
+struct RenderScheduler : juce::Timer
+{
+  static constexpr int frameRateHz = 60;
+
+  struct Client
+  {
+    virtual ~Client() = default;
+    // returns true when the client asked for a repaint
+    virtual bool renderTick() = 0;
+    // 1 = every tick, 2 = every other tick...
+    virtual int getTickDivider() const { return 1; }
+  };
+
+  struct FrameStats
+  {
+    int numClients = 0;
+    double averageTickMs = 0.0;     // analysis + curve updates, all clients, per tick
+    double averagePaintMs = 0.0;    // per reported paint
+    double repaintsPerSecond = 0.0;
+  };
+
+  ~RenderScheduler() override { stopTimer(); }
+
+  void addClient(Client *client)
+  {
+    clients.addIfNotAlreadyThere(client);
+    if (!isTimerRunning())
+      startTimerHz(frameRateHz);
+  }
+
+  void removeClient(Client *client)
+  {
+    clients.removeAllInstancesOf(client);
+    if (clients.isEmpty())
+      stopTimer();
+  }
+
+  // clients report how long their paint() took, it happens after the tick so it can't be measured here
+  void reportPaintTime(double milliseconds)
+  {
+    stats.averagePaintMs += smoothing * (milliseconds - stats.averagePaintMs);
+  }
+
+  FrameStats getFrameStats() const { return stats; }
+
+  void timerCallback() override;
+
+private:
+  static constexpr double smoothing = 0.05;
+  juce::Array<Client *> clients;
+  juce::uint64 tickCount = 0;
+  FrameStats stats;
 };
 
 struct ResponseCurveComponent : juce::Component,
                                 juce::AudioProcessorParameter::Listener,
-                                juce::Timer
+                                RenderScheduler::Client
 {
   ResponseCurveComponent(SimpleEqAudioProcessor &);
   ~ResponseCurveComponent();
   void parameterValueChanged(int parameterIndex, float newValue) override;
 
   void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {}
-  void timerCallback() override;
+  bool renderTick() override;
+  int getTickDivider() const override;
   void paint(juce::Graphics &g) override;
-  void updateChain();
   void resized() override;
 
   void toggleAnalysisEnablement(bool enabled)
   {
     shouldShowFFTAnalisis = enabled;
+    if (pathProducer != nullptr)
+      pathProducer->setConsuming(enabled);
+    repaint(getAnalysisArea());
   }
+
+  // smoothed duration of paint(), for the editor's debug overlay
+  double getAveragePaintMs() const { return averagePaintMs; }
+  void addToMemoryReport(SimpleEqAudioProcessor::MemoryReport &report) const;
 private:
+  void updateResponseCurve();
+  void renderCurveLayer();
+  void renderBackground();
+
   juce::Atomic<bool> parametersChanged{false};
-  MonoChain monoChain;
+  // what the processor runs with, the editor never designs filters itself
+  CoefficientSnapshot snapshot;
+  juce::uint64 drawnSnapshotVersion = 0;
+  BiquadResponse::FrequencyTable frequencyTable;
+  std::vector<float> mags, responseScratch;
+  juce::Path responseCurve, strokedResponseCurve;
   SimpleEqAudioProcessor &audioProcessor;
-  juce::Image background;
+  juce::Image background, curveLayer;
+  float curveLayerScale = 1.f;
+  bool curveLayerDirty = true;
+  double averagePaintMs = 0.0;
   juce::Rectangle<int> getRenderArea();
   juce::Rectangle<int> getAnalysisArea();
 
-  PathProducer leftPathProducer,rightPathProducer;
+  // created on the first tick after a paint with the analyzer enabled, see renderTick()
+  std::unique_ptr<PathProducer> pathProducer;
+  bool hasBeenPainted = false;
   bool shouldShowFFTAnalisis = true ;
+  std::atomic<float> *analyzerEnabledParameter = nullptr;
+  juce::SharedResourcePointer<RenderScheduler> renderScheduler;
  };
 
 //==============================================================================
@@ -292,7 +992,8 @@ struct AnalyzerButton : juce::ToggleButton {
   juce::Path randomPath;
 
  };
-class SimpleEqAudioProcessorEditor : public juce::AudioProcessorEditor
+class SimpleEqAudioProcessorEditor : public juce::AudioProcessorEditor,
+                                     private juce::Timer
 {
 public:
   SimpleEqAudioProcessorEditor(SimpleEqAudioProcessor &);
@@ -300,8 +1001,14 @@ public:
 
   //==============================================================================
   void paint(juce::Graphics &) override;
+  void paintOverChildren(juce::Graphics &) override;
   void resized() override;
 
+  // frame costs of the response curve and the shared render scheduler, on by default in debug builds
+  void setDebugOverlayVisible(bool shouldBeVisible);
+  // see SimpleEqAudioProcessor::getMemoryReport()
+  void addToMemoryReport(SimpleEqAudioProcessor::MemoryReport &report) const;
+
 private:
   // This reference is provided as a quick way for your editor to
   // access the processor object that created it.
@@ -336,7 +1043,12 @@ private:
       
         ResponseCurveComponent responseCurveComponent;
 
-        LookAndFeel lnf;
+        juce::SharedResourcePointer<LookAndFeel> lnf;
+
+  void timerCallback() override;
+  juce::Rectangle<int> getDebugOverlayArea() const;
+  bool debugOverlayVisible = false;
+  juce::SharedResourcePointer<RenderScheduler> renderScheduler;
   // MonoChain monoChain;
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimpleEqAudioProcessorEditor)
 };
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "PresetBank.h"
 
 //==============================================================================
 SimpleEqAudioProcessor::SimpleEqAudioProcessor()
@@ -22,6 +23,12 @@ SimpleEqAudioProcessor::SimpleEqAudioProcessor()
       )
 #endif
 {
+    // every filter gets its own coefficients once, after that they are only overwritten
+    prepareChainForInPlaceUpdates(leftChain);
+    prepareChainForInPlaceUpdates(rightChain);
+
+    if (juce::SystemStats::getEnvironmentVariable("SIMPLEEQ_TELEMETRY", {}).getIntValue() != 0)
+        setTelemetryEnabled(true);
 }
 
 SimpleEqAudioProcessor::~SimpleEqAudioProcessor()
@@ -104,12 +111,13 @@ void SimpleEqAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBloc
     leftChain.prepare(spec);
     rightChain.prepare(spec);
 
-    auto chainSettings = getChainSettings(apvts);
-
+    // prepare() cleared the filter states, redesign even if the sample rate didn't move
+    chainNeedsUpdate = true;
     updateFilter();
 
 leftChannelFifo.prepare(samplesPerBlock);
 rightChannelFifo.prepare(samplesPerBlock);
+telemetryTap.prepare(sampleRate);
 //Lambda funciton here
     osc.initialise([](float x) { return std::sin(x); });
     spec.numChannels = getTotalNumOutputChannels();
@@ -152,7 +160,10 @@ bool SimpleEqAudioProcessor::isBusesLayoutSupported(const BusesLayout &layouts)
 
 void SimpleEqAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
 {
+    TRACE_SCOPE("processBlock");
     juce::ScopedNoDenormals noDenormals;
+    const bool publishTelemetry = telemetryEnabled.load(std::memory_order_acquire);
+    const auto blockStart = publishTelemetry ? juce::Time::getHighResolutionTicks() : 0;
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -182,12 +193,15 @@ void SimpleEqAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce
     juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
 
     //then process thanks to our process chains :
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    processChainStages(leftChain, leftContext);
+    processChainStages(rightChain, rightContext);
     
+    // the fifos return straight away when no editor shows the analyzer
     rightChannelFifo.update(buffer);
     leftChannelFifo.update(buffer);
 
+    if (publishTelemetry)
+        telemetryTap.process(buffer, juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStart));
 }
 
 //==============================================================================
@@ -204,6 +218,38 @@ juce::AudioProcessorEditor *SimpleEqAudioProcessor::createEditor()
    // return new juce::GenericAudioProcessorEditor(*this);
 }
 
+bool SimpleEqAudioProcessor::setTelemetryEnabled(bool shouldPublish, const juce::String &segmentName)
+{
+  // the audio thread only touches the tap, the publisher can go at any time
+  telemetryEnabled.store(false, std::memory_order_release);
+  telemetryPublisher.reset();
+
+  if (!shouldPublish)
+    return true;
+
+  telemetryPublisher = std::make_unique<TelemetryPublisher>(telemetryTap, segmentName);
+  if (!telemetryPublisher->isValid())
+  {
+    telemetryPublisher.reset();
+    return false;
+  }
+
+  telemetryEnabled.store(true, std::memory_order_release);
+  return true;
+}
+
+SimpleEqAudioProcessor::MemoryReport SimpleEqAudioProcessor::getMemoryReport() const
+{
+  MemoryReport report;
+  report.processor = sizeof(*this);
+  report.analyzerFifos = leftChannelFifo.getAllocatedBytes() + rightChannelFifo.getAllocatedBytes();
+
+  if (auto *editor = dynamic_cast<SimpleEqAudioProcessorEditor *>(getActiveEditor()))
+    editor->addToMemoryReport(report);
+
+  return report;
+}
+
 //==============================================================================
 void SimpleEqAudioProcessor::getStateInformation(juce::MemoryBlock &destData)
 {
@@ -211,8 +257,8 @@ void SimpleEqAudioProcessor::getStateInformation(juce::MemoryBlock &destData)
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
 
-    juce::MemoryOutputStream mos(destData,true);
-    apvts.state.writeToStream(mos);
+    // fixed layout binary record, see PresetBank.h. Sessions saved before it hold a ValueTree, setStateInformation reads both
+    BinaryState::encode(BinaryState::capture(apvts), destData);
 }
 
 void SimpleEqAudioProcessor::setStateInformation(const void *data, int sizeInBytes)
@@ -220,10 +266,21 @@ void SimpleEqAudioProcessor::setStateInformation(const void *data, int sizeInByt
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
 
+    if (BinaryState::isBinaryState(data, (size_t)sizeInBytes))
+    {
+        BinaryState::Values values;
+        // same values as now (session reload, undo of nothing...) : nothing to do at all
+        if (BinaryState::decode(data, (size_t)sizeInBytes, apvts, values) && BinaryState::apply(apvts, values))
+            refreshCoefficientSnapshot();
+        return;
+    }
+
+    // states saved before the binary format
     auto tree= juce::ValueTree::readFromData(data,sizeInBytes);
     if (tree.isValid()){
         apvts.replaceState(tree);
-        updateFilter();
+        // the chains belong to the audio thread, it picks the new settings up on the next block
+        refreshCoefficientSnapshot();
     }
 }
 
@@ -246,79 +303,290 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
     settings.highCutSlope =static_cast<Slope>( apvts.getRawParameterValue("HighCut Slope")->load());
     settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
     settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-
+    settings.peakDesign = static_cast<PeakDesign>(apvts.getRawParameterValue("Peak Design")->load());
 
      settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")->load() > 0.5f;
     settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")-> load() >0.5f;
     settings.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
     return settings;
 }
-//Never forget to dereference so you can get the value because passed by ref
-void /*SimpleEqAudioProcessor::*/updateCoefficients(Coefficients& old,const Coefficients& replacement){
-    *old=*replacement;
+namespace
+{
+void writeCoefficients(Filter& filter, const BiquadResponse::Biquad& section)
+{
+    // same layout as the (1,0,0,1,0,0) objects of prepareChainForInPlaceUpdates, no allocation
+    auto* c = filter.coefficients->getRawCoefficients();
+    c[0] = section.b0;
+    c[1] = section.b1;
+    c[2] = section.b2;
+    c[3] = section.a1;
+    c[4] = section.a2;
+}
+
+void prepareCutFilter(CutFilter& cut)
+{
+    cut.get<0>().coefficients = new juce::dsp::IIR::Coefficients<float>(1, 0, 0, 1, 0, 0);
+    cut.get<1>().coefficients = new juce::dsp::IIR::Coefficients<float>(1, 0, 0, 1, 0, 0);
+    cut.get<2>().coefficients = new juce::dsp::IIR::Coefficients<float>(1, 0, 0, 1, 0, 0);
+    cut.get<3>().coefficients = new juce::dsp::IIR::Coefficients<float>(1, 0, 0, 1, 0, 0);
+}
+
+void applyCutFilter(CutFilter& cut, const std::array<BiquadResponse::Biquad, 4>& sections, int stages)
+{
+    // stage i runs when the slope needs more than i sections
+    writeCoefficients(cut.get<0>(), sections[0]);
+    writeCoefficients(cut.get<1>(), sections[1]);
+    writeCoefficients(cut.get<2>(), sections[2]);
+    writeCoefficients(cut.get<3>(), sections[3]);
+    cut.setBypassed<0>(stages < 1);
+    cut.setBypassed<1>(stages < 2);
+    cut.setBypassed<2>(stages < 3);
+    cut.setBypassed<3>(stages < 4);
+}
 }
 
-  void SimpleEqAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings){
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    ChainCoefficients coefficients;
+    coefficients.lowCutBypassed = chainSettings.lowCutBypassed;
+    coefficients.peakBypassed = chainSettings.peakBypassed;
+    coefficients.highCutBypassed = chainSettings.highCutBypassed;
+
+    // nothing can be designed before the host gave us a sample rate, everything stays flat
+    if (sampleRate <= 0.0)
+        return coefficients;
+
+    // same designs as juce::dsp::FilterDesign and IIR::Coefficients::makePeakFilter, without allocating,
+    // so this is safe on the audio thread and for every step of a morph
+    coefficients.lowCutStages = ChainDesign::butterworthHighPass(sampleRate, chainSettings.lowCutFreq,
+                                                                 (chainSettings.lowCutSlope + 1) * 2, coefficients.lowCut.data());
+    coefficients.highCutStages = ChainDesign::butterworthLowPass(sampleRate, chainSettings.highCutFreq,
+                                                                 (chainSettings.highCutSlope + 1) * 2, coefficients.highCut.data());
+    auto peakGain = juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels);
+    coefficients.peak = chainSettings.peakDesign == PeakDesign::PeakDesign_Matched
+                            ? ChainDesign::peakMatched(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, peakGain)
+                            : ChainDesign::peak(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, peakGain);
+    return coefficients;
+}
 
-    auto cutCoefficient = makeLowCutFilter(chainSettings,getSampleRate());
-// //pourquoi ici on fait une reference ??
-leftChain.setBypassed<ChainPosition::LowCut>(chainSettings.lowCutBypassed);
+void prepareChainForInPlaceUpdates(MonoChain& chain)
+{
+    prepareCutFilter(chain.get<ChainPosition::LowCut>());
+    chain.get<ChainPosition::Peak>().coefficients = new juce::dsp::IIR::Coefficients<float>(1, 0, 0, 1, 0, 0);
+    prepareCutFilter(chain.get<ChainPosition::HighCut>());
+}
 
-rightChain.setBypassed<ChainPosition::LowCut>(chainSettings.lowCutBypassed);
+void applyChainCoefficients(MonoChain& chain, const ChainCoefficients& coefficients)
+{
+    applyCutFilter(chain.get<ChainPosition::LowCut>(), coefficients.lowCut, coefficients.lowCutStages);
+    writeCoefficients(chain.get<ChainPosition::Peak>(), coefficients.peak);
+    applyCutFilter(chain.get<ChainPosition::HighCut>(), coefficients.highCut, coefficients.highCutStages);
 
-    auto& leftLowCut = leftChain.get<ChainPosition::LowCut>();
-     updateCutFilter(leftLowCut,cutCoefficient,chainSettings.lowCutSlope);
+    chain.setBypassed<ChainPosition::LowCut>(coefficients.lowCutBypassed);
+    chain.setBypassed<ChainPosition::Peak>(coefficients.peakBypassed);
+    chain.setBypassed<ChainPosition::HighCut>(coefficients.highCutBypassed);
+}
 
+namespace
+{
+// what ProcessorChain::process does for one stage : a bypassed stage still runs, with isBypassed set,
+// so its filters keep their state in step with the signal and un-bypassing it doesn't click
+template <int Index>
+void processChainStage(MonoChain& chain, const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto stageContext = context;
+    stageContext.isBypassed = context.isBypassed || chain.isBypassed<Index>();
+    chain.get<Index>().process(stageContext);
+}
+}
 
-    auto& rightLowCut = rightChain.get<ChainPosition::LowCut>();
-     updateCutFilter(rightLowCut,cutCoefficient,chainSettings.lowCutSlope);
-  }
+void processChainStages(MonoChain& chain, const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    {
+        TRACE_SCOPE("LowCut");
+        processChainStage<ChainPosition::LowCut>(chain, context);
+    }
+    {
+        TRACE_SCOPE("Peak");
+        processChainStage<ChainPosition::Peak>(chain, context);
+    }
+    {
+        TRACE_SCOPE("HighCut");
+        processChainStage<ChainPosition::HighCut>(chain, context);
+    }
+}
 
-  void SimpleEqAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings){
-  auto highCutCoefficient = makeHighCutFilter(chainSettings,getSampleRate());
- auto& leftHighCut = leftChain.get<ChainPosition::HighCut>();
+/**
+ * Audio thread. The filters are only redesigned when a parameter or the sample rate moved,
+ * and what they run with is published for the editors right after.
+ */
+void SimpleEqAudioProcessor::updateFilter(){
+    TRACE_SCOPE("updateFilter");
+    // while a morph runs the message thread designs for us, we only take its latest result
+    if (morphActive.load(std::memory_order_acquire))
+    {
+        if (morphBuffer.update())
+        {
+            const auto& morph = morphBuffer.getReadBuffer();
+            currentCoefficients = morph.coefficients;
+            applyChainCoefficients(leftChain, currentCoefficients);
+            applyChainCoefficients(rightChain, currentCoefficients);
+            currentSettings = morph.settings;
+            currentSampleRate = morph.sampleRate;
+            snapshotPending = true;
+        }
+    }
+    else
+    {
+        updateChainFromParameters();
+    }
 
-leftChain.setBypassed<ChainPosition::HighCut>(chainSettings.highCutBypassed);
+    // never wait on the message thread here, if it is publishing we just try again next block
+    if (snapshotPending)
+        snapshotPending = !publishCoefficients(currentSettings, currentSampleRate, currentCoefficients, false);
+}
 
-rightChain.setBypassed<ChainPosition::HighCut>(chainSettings.highCutBypassed);
-    updateCutFilter(leftHighCut,highCutCoefficient,chainSettings.highCutSlope);
+void SimpleEqAudioProcessor::updateChainFromParameters()
+{
+    auto chainSettings = getChainSettings(apvts);
+    auto sampleRate = getSampleRate();
+
+    if (chainNeedsUpdate || chainSettings != currentSettings || sampleRate != currentSampleRate)
+    {
+        currentCoefficients = makeChainCoefficients(chainSettings, sampleRate);
+        applyChainCoefficients(leftChain, currentCoefficients);
+        applyChainCoefficients(rightChain, currentCoefficients);
+
+        currentSettings = chainSettings;
+        currentSampleRate = sampleRate;
+        chainNeedsUpdate = false;
+        snapshotPending = true;
+    }
+}
+
+bool SimpleEqAudioProcessor::publishCoefficients(const ChainSettings& chainSettings, double sampleRate,
+                                                 const ChainCoefficients& coefficients, bool canWait)
+{
+    // the seqlock wants a single writer at a time, audio and message thread both publish
+    if (canWait)
+        publishLock.enter();
+    else if (!publishLock.tryEnter())
+        return false;
 
+    CoefficientSnapshot snapshot;
+    snapshot.version = snapshotVersion.load(std::memory_order_relaxed) + 1;
+    snapshot.sampleRate = sampleRate;
+    snapshot.settings = chainSettings;
+    snapshot.coefficients = coefficients;
 
+    coefficientSnapshot.write(snapshot);
+    snapshotVersion.store(snapshot.version, std::memory_order_release);
 
-    auto& rightHighCut = rightChain.get<ChainPosition::HighCut>();
-    updateCutFilter(rightHighCut,highCutCoefficient,chainSettings.highCutSlope);
-  }
-void SimpleEqAudioProcessor::updateFilter(){
+    publishLock.exit();
+    return true;
+}
+
+void SimpleEqAudioProcessor::refreshCoefficientSnapshot()
+{
     auto chainSettings = getChainSettings(apvts);
-    updateLowCutFilters(chainSettings);
-    updateHighCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
+    auto sampleRate = getSampleRate();
+
+    auto current = coefficientSnapshot.read();
+    if (current.version != 0 && current.settings == chainSettings && current.sampleRate == sampleRate)
+        return;
+
+    // designed with the same functions as the audio thread, so the result is identical to what it will run
+    publishCoefficients(chainSettings, sampleRate, makeChainCoefficients(chainSettings, sampleRate), true);
+}
+//=======================
+void SimpleEqAudioProcessor::storeSnapshot(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, numSnapshots));
+    snapshots[slot] = getChainSettings(apvts);
+    snapshotStored[slot] = true;
+}
+
+void SimpleEqAudioProcessor::recallSnapshot(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, numSnapshots));
+    if (!snapshotStored[slot])
+        return;
+
+    endMorph(false);
+    // only the parameters that differ move, the audio thread redesigns on its next block
+    setChainSettings(apvts, snapshots[slot]);
+    refreshCoefficientSnapshot();
 }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings,double sampleRate){
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                        chainSettings.peakFreq
-                                                        ,chainSettings.peakQuality,
-                                                        juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+void SimpleEqAudioProcessor::setMorph(int slotA, int slotB, float amount)
+{
+    jassert(juce::isPositiveAndBelow(slotA, numSnapshots) && juce::isPositiveAndBelow(slotB, numSnapshots));
+    if (!snapshotStored[slotA] || !snapshotStored[slotB])
+        return;
+
+    // designed here, published wait free : the audio thread just copies the latest one in
+    auto& morph = morphBuffer.getWriteBuffer();
+    morph.settings = morphChainSettings(snapshots[slotA], snapshots[slotB], amount);
+    morph.sampleRate = getSampleRate();
+    morph.coefficients = makeChainCoefficients(morph.settings, morph.sampleRate);
+    morphedSettings = morph.settings;
+    morphBuffer.publish();
+
+    morphActive.store(true, std::memory_order_release);
 }
-void SimpleEqAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings){
-     //On crée le filtre avec tous les bons coefficients qu'on veut attention au gain
-    // auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(),
-    //                                                     chainSettings.peakFreq
-    //                                                     ,chainSettings.peakQuality,
-    //                                                     juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
-    //Be carefull with the dereference as it s put on the heap 
-    auto peakCoefficients = makePeakFilter(chainSettings,getSampleRate());
-    leftChain.setBypassed<ChainPosition::Peak>(chainSettings.peakBypassed);
 
-rightChain.setBypassed<ChainPosition::Peak>(chainSettings.peakBypassed);
-    updateCoefficients(leftChain.get<ChainPosition::Peak>().coefficients,peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPosition::Peak>().coefficients,peakCoefficients);
+void SimpleEqAudioProcessor::endMorph(bool keepMorphedSettings)
+{
+    if (!morphActive.load(std::memory_order_relaxed))
+        return;
 
+    // keeping the result : the parameters follow, so the audio thread has nothing left to redesign
+    if (keepMorphedSettings)
+        setChainSettings(apvts, morphedSettings);
 
+    morphActive.store(false, std::memory_order_release);
+    refreshCoefficientSnapshot();
+}
+
+ChainSettings morphChainSettings(const ChainSettings& a, const ChainSettings& b, float amount)
+{
+    amount = juce::jlimit(0.f, 1.f, amount);
+    // frequencies and Q move on a log scale like the sliders, the gain in dB, the switches at half way
+    auto geometric = [amount](float x, float y) { return x * std::pow(y / x, amount); };
+    const auto& nearest = amount < 0.5f ? a : b;
+
+    ChainSettings settings = nearest;
+    settings.lowCutFreq = geometric(a.lowCutFreq, b.lowCutFreq);
+    settings.highCutFreq = geometric(a.highCutFreq, b.highCutFreq);
+    settings.peakFreq = geometric(a.peakFreq, b.peakFreq);
+    settings.peakQuality = geometric(a.peakQuality, b.peakQuality);
+    settings.peakGainInDecibels = a.peakGainInDecibels + amount * (b.peakGainInDecibels - a.peakGainInDecibels);
+    return settings;
+}
 
+void setChainSettings(juce::AudioProcessorValueTreeState& apvts, const ChainSettings& settings)
+{
+    auto set = [&apvts](const char* id, float value)
+    {
+        if (apvts.getRawParameterValue(id)->load() == value)
+            return;
+        auto* param = apvts.getParameter(id);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    };
+
+    set("LowCut Freq", settings.lowCutFreq);
+    set("HighCut Freq", settings.highCutFreq);
+    set("Peak Freq", settings.peakFreq);
+    set("Peak Gain", settings.peakGainInDecibels);
+    set("Peak Quality", settings.peakQuality);
+    set("Peak Design", (float)settings.peakDesign);
+    set("LowCut Slope", (float)settings.lowCutSlope);
+    set("HighCut Slope", (float)settings.highCutSlope);
+    set("LowCut Bypassed", settings.lowCutBypassed ? 1.f : 0.f);
+    set("Peak Bypassed", settings.peakBypassed ? 1.f : 0.f);
+    set("HighCut Bypassed", settings.highCutBypassed ? 1.f : 0.f);
 }
-//=======================
+
 /**
  * /3 differents kind of bands : high cut, low cut and bands
  * fist 2 ones we can controle slope anf freq
@@ -376,6 +644,20 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEqAudioProcessor::crea
     layout.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed","Peak Bypass",false));
     layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed","HighCut Bypass",false));
     layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Enabled","Analyzer Enabled",true));
+    //Same order as the FFTOrder enum of the editor, 4096 stays the default
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Resolution","Analyzer Resolution",
+                                                            juce::StringArray{"2048","4096","8192"},1));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Mode","Analyzer Mode",
+                                                            juce::StringArray{"Standard","Multi-Resolution"},0));
+    //Spectrogram keeps the spectrum line and scrolls the history under it
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer View","Analyzer View",
+                                                            juce::StringArray{"Spectrum","Spectrogram"},0));
+    //Matched cramps high bells much less than Bilinear (see ChainDesign::peakMatched), Bilinear stays the default so old sessions sound the same
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Peak Design","Peak Design",
+                                                            juce::StringArray{"Bilinear","Matched"},0));
+    //Mid and Side come from the same transform as Left and Right, they only add two traces to draw
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Channels","Analyzer Channels",
+                                                            juce::StringArray{"Left/Right","Left/Right + Mid/Side"},0));
 
 
 
@@ -10,13 +10,77 @@
 
 #include <JuceHeader.h>
 #include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include "BiquadResponse.h"
+#include "ChainDesign.h"
+#include "SeqLock.h"
+#include "TelemetryExport.h"
+#include "TraceRecorder.h"
+
+/**
+ Keeps a reader thread out of a structure while its owner re-prepares it.
+ The reader wraps every access in a Scope and backs off when it couldn't enter,
+ the owner calls close() (waits until the reader has left), reallocates, then open().
+ Both sides are seq_cst so one of them always sees the other (Dekker style).
+ */
+struct ReaderHandshake
+{
+    struct Scope
+    {
+        explicit Scope(ReaderHandshake& h) : handshake(h)
+        {
+            handshake.readerActive.store(true);
+            entered = handshake.isOpen.load();
+            if( ! entered )
+                handshake.readerActive.store(false);
+        }
+
+        ~Scope()
+        {
+            if( entered )
+                handshake.readerActive.store(false);
+        }
+
+        bool isEntered() const { return entered; }
+    private:
+        ReaderHandshake& handshake;
+        bool entered = false;
+    };
+
+    // owner side, never on the audio thread : it may wait for the reader to finish a read
+    void close()
+    {
+        isOpen.store(false);
+        while( readerActive.load() )
+            std::this_thread::yield();
+    }
+
+    void open() { isOpen.store(true); }
+    bool isClosed() const { return ! isOpen.load(); }
+private:
+    std::atomic<bool> isOpen { false }, readerActive { false };
+};
+
+/**
+ Single producer / single consumer queue of 'Capacity' elements, push() drops the element
+ when it is full. prepare() belongs to the producer thread : it keeps the reader out
+ while the elements are resized, and empties the queue since what was in it is gone.
+ */
 template<typename T>
 struct Fifo
 {
+    Fifo()
+    {
+        handshake.open();
+    }
+
     void prepare(int numChannels, int numSamples)
     {
         static_assert( std::is_same_v<T, juce::AudioBuffer<float>>,
                       "prepare(numChannels, numSamples) should only be used when the Fifo is holding juce::AudioBuffer<float>");
+        handshake.close();
         for( auto& buffer : buffers)
         {
             buffer.setSize(numChannels,
@@ -26,17 +90,22 @@ struct Fifo
                            true);   //avoid reallocating if you can?
             buffer.clear();
         }
+        fifo.reset();
+        handshake.open();
     }
     
     void prepare(size_t numElements)
     {
         static_assert( std::is_same_v<T, std::vector<float>>,
                       "prepare(numElements) should only be used when the Fifo is holding std::vector<float>");
+        handshake.close();
         for( auto& buffer : buffers )
         {
             buffer.clear();
             buffer.resize(numElements, 0);
         }
+        fifo.reset();
+        handshake.open();
     }
     
     bool push(const T& t)
@@ -53,6 +122,10 @@ struct Fifo
     
     bool pull(T& t)
     {
+        ReaderHandshake::Scope scope(handshake);
+        if( ! scope.isEntered() )
+            return false;
+
         auto read = fifo.read(1);
         if( read.blockSize1 > 0 )
         {
@@ -65,12 +138,23 @@ struct Fifo
     
     int getNumAvailableForReading() const
     {
-        return fifo.getNumReady();
+        ReaderHandshake::Scope scope(handshake);
+        return scope.isEntered() ? fifo.getNumReady() : 0;
+    }
+
+    // reader side : drops everything that was pushed so far
+    void discardAll()
+    {
+        ReaderHandshake::Scope scope(handshake);
+        if( scope.isEntered() )
+            fifo.finishedRead(fifo.getNumReady());
     }
 private:
     static constexpr int Capacity = 30;
     std::array<T, Capacity> buffers;
     juce::AbstractFifo fifo {Capacity};
+    // the reader only enters from a const member
+    mutable ReaderHandshake handshake;
 };
 
 enum Channel
@@ -82,65 +166,210 @@ enum Channel
 template<typename BlockType>
 struct SingleChannelSampleFifo
 {
+    /**
+     The audio thread writes the samples straight into a ring, the reader takes them back
+     'size' samples at a time. The analyzer only wants the latest audio : the writer never
+     waits and overwrites the oldest samples, a late reader skips ahead to the newest half
+     of the ring (4 Hz ticks of a hidden editor included) and throws away a read the writer
+     caught up with while it was copying.
+
+     Positions count the samples given to update() since prepare(), whether somebody listens
+     or not, so two fifos fed by the same processBlock always agree on them (see PathProducer).
+     */
+    static constexpr int minRingSize = 8192;
+
     SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
     {
-        prepared.set(false);
     }
     
     void update(const BlockType& buffer)
     {
-        jassert(prepared.get());
+        jassert( ! handshake.isClosed() );
         jassert(buffer.getNumChannels() > channelToUse );
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
-        
-        for( int i = 0; i < buffer.getNumSamples(); ++i )
+
+        auto numSamples = buffer.getNumSamples();
+        auto position = writePosition.load(std::memory_order_relaxed);
+        auto end = position + (juce::uint64)numSamples;
+
+        // nobody reads us : don't even look at the samples
+        if( numConsumers.load(std::memory_order_acquire) == 0 )
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            writeStarted.store(end, std::memory_order_relaxed);
+            writePosition.store(end, std::memory_order_release);
+            return;
         }
+
+        TRACE_SCOPE("SingleChannelSampleFifo::update");
+        auto* channelPtr = buffer.getReadPointer(channelToUse);
+
+        // announced before the samples land, like a seqlock : a reader checks it after copying
+        writeStarted.store(end, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // a block longer than the ring : only its end survives anyway
+        for( int i = juce::jmax(0, numSamples - capacity); i < numSamples; ++i )
+            ring[(position + (juce::uint64)i) & mask].store(channelPtr[i], std::memory_order_relaxed);
+
+        writePosition.store(end, std::memory_order_release);
     }
 
+    /**
+     Same thread as update(). The reader is kept out while the ring is reallocated,
+     so this may wait for a read in progress to finish.
+     */
     void prepare(int bufferSize)
     {
-        prepared.set(false);
-        size.set(bufferSize);
-        
-        bufferToFill.setSize(1,             //channel
-                             bufferSize,    //num samples
-                             false,         //keepExistingContent
-                             true,          //clear extra space
-                             true);         //avoid reallocating
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
-        prepared.set(true);
+        handshake.close();
+
+        size.store(bufferSize);
+        capacity = (int)juce::nextPowerOfTwo(juce::jmax(minRingSize, bufferSize * 4));
+        mask = (juce::uint64)capacity - 1;
+        if( capacity > allocated )
+        {
+            ring = std::make_unique<std::atomic<float>[]>((size_t)capacity);
+            allocated = capacity;
+        }
+
+        writePosition.store(0);
+        writeStarted.store(0);
+        readPosition.store(0);
+        handshake.open();
     }
     //==============================================================================
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
-    bool isPrepared() const { return prepared.get(); }
-    int getSize() const { return size.get(); }
+    /**
+     The audio thread only copies samples while at least one consumer is attached.
+     Attaching (reader thread) skips what is in the ring, so the consumer never sees what
+     was left there the last time somebody listened.
+     */
+    void attachConsumer()
+    {
+        {
+            ReaderHandshake::Scope scope(handshake);
+            if( scope.isEntered() && numConsumers.load(std::memory_order_relaxed) == 0 )
+                readPosition.store(writePosition.load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+        numConsumers.fetch_add(1, std::memory_order_release);
+    }
+    void detachConsumer()
+    {
+        jassert(numConsumers.load() > 0);
+        numConsumers.fetch_sub(1, std::memory_order_release);
+    }
+    bool hasConsumer() const { return numConsumers.load(std::memory_order_acquire) > 0; }
+    //==============================================================================
+    int getNumCompleteBuffersAvailable()
+    {
+        ReaderHandshake::Scope scope(handshake);
+        auto bufferSize = size.load();
+        if( ! scope.isEntered() || bufferSize <= 0 )
+            return 0;
+
+        return (int)((writePosition.load(std::memory_order_acquire) - getNextReadPositionUnchecked()) / (juce::uint64)bufferSize);
+    }
+    bool isPrepared() const { return ! handshake.isClosed(); }
+    int getSize() const { return size.load(); }
     //==============================================================================
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
+    // reader thread : where the next read starts, after skipping what the writer is about to overwrite
+    juce::uint64 getNextReadPosition()
+    {
+        ReaderHandshake::Scope scope(handshake);
+        return scope.isEntered() ? getNextReadPositionUnchecked() : 0;
+    }
+
+    // reader thread : the next 'size' samples, 'buf' only reallocates if it was smaller
+    bool getAudioBuffer(BlockType& buf)
+    {
+        return getAudioBuffer(buf, getNextReadPosition());
+    }
+
+    /**
+     Reader thread : 'size' samples from 'position' on, which must not be behind the last read.
+     False when they haven't been written yet, or were overwritten (then nothing is consumed).
+     */
+    bool getAudioBuffer(BlockType& buf, juce::uint64 position)
+    {
+        ReaderHandshake::Scope scope(handshake);
+        auto bufferSize = size.load();
+        if( ! scope.isEntered() || bufferSize <= 0 )
+            return false;
+
+        auto written = writePosition.load(std::memory_order_acquire);
+        if( position < readPosition.load(std::memory_order_relaxed) || written < position + (juce::uint64)bufferSize )
+            return false;
+
+        buf.setSize(1, bufferSize, false, false, true);
+        auto* dest = buf.getWritePointer(0);
+        for( int i = 0; i < bufferSize; ++i )
+            dest[i] = ring[(position + (juce::uint64)i) & mask].load(std::memory_order_relaxed);
+
+        // the writer may have lapped us during the copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if( writeStarted.load(std::memory_order_relaxed) > position + (juce::uint64)capacity )
+            return false;
+
+        readPosition.store(position + (juce::uint64)bufferSize, std::memory_order_relaxed);
+        return true;
+    }
+
+    // heap memory of the ring, the object itself is part of the processor
+    size_t getAllocatedBytes() const { return (size_t)allocated * sizeof(float); }
 private:
+    // keeps the newest half of the ring, skipping on the grid of the reads so they stay whole buffers
+    juce::uint64 getNextReadPositionUnchecked() const
+    {
+        auto written = writePosition.load(std::memory_order_acquire);
+        auto position = readPosition.load(std::memory_order_relaxed);
+        auto keep = (juce::uint64)(capacity / 2);
+        auto bufferSize = (juce::uint64)juce::jmax(1, size.load());
+
+        if( written > position + keep )
+            position += (written - position - keep + bufferSize - 1) / bufferSize * bufferSize;
+        return position;
+    }
+
     Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
-    juce::Atomic<bool> prepared = false;
-    juce::Atomic<int> size = 0;
-    
-    void pushNextSampleIntoFifo(float sample)
+    // only changed by prepare(), while the reader is kept out
+    std::unique_ptr<std::atomic<float>[]> ring;
+    int capacity = 0, allocated = 0;
+    juce::uint64 mask = 0;
+    std::atomic<juce::uint64> writePosition { 0 }, writeStarted { 0 }, readPosition { 0 };
+    std::atomic<int> size { 0 };
+    std::atomic<int> numConsumers { 0 };
+    ReaderHandshake handshake;
+};
+
+/**
+ Single producer / single consumer hand over of the latest value, wait free on both sides.
+ The producer fills getWriteBuffer() then publish(), the consumer calls update() and reads
+ getReadBuffer() if it returned true. Values published in between are simply skipped.
+ */
+template<typename T>
+struct TripleBuffer
+{
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+
+    void publish() noexcept
     {
-        if (fifoIndex == bufferToFill.getNumSamples())
-        {
-            auto ok = audioBufferFifo.push(bufferToFill);
+        auto previous = middle.exchange(writeIndex | dirty, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
 
-            juce::ignoreUnused(ok);
-            
-            fifoIndex = 0;
-        }
-        
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
+    bool update() noexcept
+    {
+        if( (middle.load(std::memory_order_relaxed) & dirty) == 0 )
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
     }
+
+    const T& getReadBuffer() const { return buffers[readIndex]; }
+private:
+    static constexpr int dirty = 4, indexMask = 3;
+    std::array<T, 3> buffers {};
+    int writeIndex = 0, readIndex = 1;
+    std::atomic<int> middle { 2 };
 };
 
 enum Slope
@@ -155,13 +384,54 @@ enum Slope
  * We define a struct to regroup every single one of our parameters :
  */
 
+// how the peak band is designed, see ChainDesign::peak and ChainDesign::peakMatched
+enum PeakDesign
+{
+  PeakDesign_Bilinear,
+  PeakDesign_Matched
+};
+
 struct ChainSettings
 {
   float peakFreq{0}, peakGainInDecibels{0}, peakQuality{1.f};
+  PeakDesign peakDesign{PeakDesign::PeakDesign_Bilinear};
   float lowCutFreq{0}, highCutFreq{20000};
   Slope lowCutSlope{Slope::Slope_12}, highCutSlope{Slope::Slope_12};
   bool lowCutBypassed { false } , highCutBypassed { false},  peakBypassed{false };
 };
+
+inline bool operator==(const ChainSettings& a, const ChainSettings& b)
+{
+  return a.peakFreq == b.peakFreq && a.peakGainInDecibels == b.peakGainInDecibels && a.peakQuality == b.peakQuality
+      && a.peakDesign == b.peakDesign
+      && a.lowCutFreq == b.lowCutFreq && a.highCutFreq == b.highCutFreq
+      && a.lowCutSlope == b.lowCutSlope && a.highCutSlope == b.highCutSlope
+      && a.lowCutBypassed == b.lowCutBypassed && a.highCutBypassed == b.highCutBypassed && a.peakBypassed == b.peakBypassed;
+}
+inline bool operator!=(const ChainSettings& a, const ChainSettings& b) { return !(a == b); }
+
+/**
+ Plain copy of every coefficient the chain runs with, one section per 12 dB/oct of the cuts.
+ */
+struct ChainCoefficients
+{
+  std::array<BiquadResponse::Biquad, 4> lowCut, highCut;
+  int lowCutStages = 1, highCutStages = 1;
+  BiquadResponse::Biquad peak;
+  bool lowCutBypassed = false, peakBypassed = false, highCutBypassed = false;
+};
+
+/**
+ What the processor publishes for the editors : the coefficients, the settings and the
+ sample rate they were designed for. 'version' grows every time something changed.
+ */
+struct CoefficientSnapshot
+{
+  juce::uint64 version = 0;
+  double sampleRate = 0.0;
+  ChainSettings settings;
+  ChainCoefficients coefficients;
+};
   enum ChainPosition
   {
     LowCut,
@@ -170,69 +440,25 @@ struct ChainSettings
   };
   using Filter = juce::dsp::IIR::Filter<float>;
 
-  using Coefficients = Filter::CoefficientsPtr;
-
-  // Static method to avoid over us of the memory
-  void updateCoefficients(Coefficients &old, const Coefficients &replacement);
-  Coefficients makePeakFilter(const ChainSettings& chainSettings,double sampleRate);
- // We re defining here a lot of aliases to avoid doing extra stuff you know :
- template <int Index, typename ChainType, typename CoefficientType>
-  void update(ChainType &chain, const CoefficientType &coefficient)
-  {
-    updateCoefficients(chain.get<Index>().coefficients, coefficient[Index]);
-    chain.setBypassed<Index>(false);
-  }
-  // Damn here we go for the template function so it can be use wether by the low cut or the high cut
-  template <typename ChainType, typename CoefficientType>
-  void updateCutFilter(ChainType &leftLowCut,
-                       const CoefficientType &cutCoefficient,
-                       const Slope &lowCutSlope)
-  {
-
-    leftLowCut.setBypassed<0>(true);
-    leftLowCut.setBypassed<1>(true);
-    leftLowCut.setBypassed<2>(true);
-    leftLowCut.setBypassed<3>(true);
-    // Petit trick de faire a l envers oiur pas generer plus de code que pévu
-    switch (lowCutSlope)
-    {
-    case Slope_48:
-    {
-      update<3>(leftLowCut, cutCoefficient);
-    }
-    case Slope_32:
-    {
-      update<2>(leftLowCut, cutCoefficient);
-    }
-    // break;
-    case Slope_24:
-    {
-      update<1>(leftLowCut, cutCoefficient);
-    }
-    case Slope_12:
-    {
-      update<0>(leftLowCut, cutCoefficient);
-    }
-    }
-  }
-
-
-  inline auto makeLowCutFilter(const ChainSettings& chainSettings,double sampleRate)
-  {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,sampleRate,(chainSettings.lowCutSlope+1)*2);
-  }
-
-  inline auto makeHighCutFilter(const ChainSettings& chainSettings,double sampleRate)
-  {
-        return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,sampleRate,(chainSettings.highCutSlope+1)*2);
-
-  }
   // 4 filter so it cans do - 48 db because each is 12; So here we re using the precedent filters to declare a chain that will create our
   // Low cuts and high cuts filter
   using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
   // Lets create the moni chian we could use on every mono channel :
   using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+
+  // designs every coefficient of the chain for these settings
+  ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate);
+  // gives every filter of the chain its own second order coefficients so applyChainCoefficients can write in place
+  void prepareChainForInPlaceUpdates(MonoChain& chain);
+  // copies the coefficients into the chain without allocating, the chain must have been prepared first
+  void applyChainCoefficients(MonoChain& chain, const ChainCoefficients& coefficients);
+  // chain.process(context) one stage at a time, so each stage gets its own trace marker
+  void processChainStages(MonoChain& chain, const juce::dsp::ProcessContextReplacing<float>& context);
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts);
+// sets the parameters that differ from 'settings', message thread
+void setChainSettings(juce::AudioProcessorValueTreeState &apvts, const ChainSettings &settings);
+// 'amount' = 0 gives a, 1 gives b
+ChainSettings morphChainSettings(const ChainSettings &a, const ChainSettings &b, float amount);
 //==============================================================================
 /**
  */
@@ -288,6 +514,52 @@ public:
   SingleChannelSampleFifo<BlockType> leftChannelFifo {Channel::Left};
   SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right};
 
+  //========================================
+  // Latest coefficients designed by the processor, readable from any thread without locking
+  CoefficientSnapshot getCoefficientSnapshot() const { return coefficientSnapshot.read(); }
+  juce::uint64 getCoefficientSnapshotVersion() const { return snapshotVersion.load(std::memory_order_acquire); }
+  // message thread : publishes the current parameters if the audio thread didn't do it yet (e.g. transport stopped)
+  void refreshCoefficientSnapshot();
+
+  //========================================
+  // A/B/C/D comparison, message thread. Recalling is instant : only the parameters that differ move.
+  static constexpr int numSnapshots = 4;
+  void storeSnapshot(int slot);
+  bool hasSnapshot(int slot) const { return snapshotStored[slot]; }
+  void recallSnapshot(int slot);
+  /**
+   Continuous morph between two stored snapshots. Each call designs the in between chain and hands it
+   to the audio thread wait free, the parameters don't move until endMorph(true).
+   */
+  void setMorph(int slotA, int slotB, float amount);
+  void endMorph(bool keepMorphedSettings);
+  bool isMorphing() const { return morphActive.load(std::memory_order_relaxed); }
+
+  //========================================
+  // What one instance holds in memory, in bytes. The FFT tables are shared by every instance
+  // of the process, they are reported apart and not counted in perInstance().
+  struct MemoryReport
+  {
+    size_t processor = 0;      // the processor object, chains and snapshots included
+    size_t analyzerFifos = 0;  // the sample rings the audio thread feeds
+    size_t editorAnalyzer = 0; // histories, spectra, paths and spectrogram of the open editor
+    size_t editorCurve = 0;    // the editor itself, cached layers and response curve buffers
+    size_t sharedTables = 0;
+
+    size_t perInstance() const { return processor + analyzerFifos + editorAnalyzer + editorCurve; }
+  };
+  // message thread, the editor part is only there while an editor is open
+  MemoryReport getMemoryReport() const;
+
+  //========================================
+  /**
+   Ops telemetry : latest spectrum, levels and dsp load in a shared memory segment (TelemetryExport.h),
+   off unless this is called or SIMPLEEQ_TELEMETRY=1 is in the environment.
+   Message thread, false when the segment couldn't be created. An empty name picks a unique one.
+   */
+  bool setTelemetryEnabled(bool shouldPublish, const juce::String &segmentName = {});
+  juce::String getTelemetrySegmentName() const { return telemetryPublisher != nullptr ? telemetryPublisher->getSegmentName() : juce::String(); }
+
 private:
  
   // To use this in stereo, we create 2 instances
@@ -295,16 +567,37 @@ private:
   // Be carefull with the order as this this will be used to access the peak in the chain
 
 
-  void updatePeakFilter(const ChainSettings &ChainSettings);
-  // We declare an aliase on the coefficient to change them more easily
-  
- 
+  void updateFilter();
+  void updateChainFromParameters();
+  bool publishCoefficients(const ChainSettings& chainSettings, double sampleRate, const ChainCoefficients& coefficients, bool canWait);
 
-  //More refactor :
-  void updateLowCutFilters(const ChainSettings& chainSettings);
-  void updateHighCutFilters(const ChainSettings& chainSettings);
+  // what the chains currently run with, audio thread only once playing
+  ChainSettings currentSettings;
+  double currentSampleRate = 0.0;
+  bool chainNeedsUpdate = true;
+  bool snapshotPending = false;
+  ChainCoefficients currentCoefficients;
 
-  void updateFilter();
+  SeqLock<CoefficientSnapshot> coefficientSnapshot;
+  std::atomic<juce::uint64> snapshotVersion { 0 };
+  juce::SpinLock publishLock;
+
+  struct MorphState
+  {
+    ChainSettings settings;
+    double sampleRate = 0.0;
+    ChainCoefficients coefficients;
+  };
+  std::array<ChainSettings, numSnapshots> snapshots;
+  std::array<bool, numSnapshots> snapshotStored {};
+  ChainSettings morphedSettings;
+  TripleBuffer<MorphState> morphBuffer;
+  std::atomic<bool> morphActive { false };
+
+  // the tap outlives the publisher reading it
+  TelemetryTap telemetryTap;
+  std::unique_ptr<TelemetryPublisher> telemetryPublisher;
+  std::atomic<bool> telemetryEnabled { false };
 
   //=====================================================================
   /**
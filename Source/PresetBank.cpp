@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    Compact binary state and memory-mapped preset banks, see PresetBank.h
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+juce::uint32 readUInt32(const char* p) { return juce::ByteOrder::littleEndianInt(p); }
+juce::uint16 readUInt16(const char* p) { return juce::ByteOrder::littleEndianShort(p); }
+
+float readFloat(const char* p)
+{
+  auto bits = juce::ByteOrder::littleEndianInt(p);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void writeUInt32(char* p, juce::uint32 value)
+{
+  value = juce::ByteOrder::swapIfBigEndian(value);
+  std::memcpy(p, &value, sizeof(value));
+}
+
+void writeUInt16(char* p, juce::uint16 value)
+{
+  value = juce::ByteOrder::swapIfBigEndian(value);
+  std::memcpy(p, &value, sizeof(value));
+}
+
+void writeFloat(char* p, float value)
+{
+  juce::uint32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  writeUInt32(p, bits);
+}
+}
+
+//==============================================================================
+BinaryState::Values BinaryState::capture(juce::AudioProcessorValueTreeState& apvts)
+{
+  Values values;
+  for (int i = 0; i < numParameters; ++i)
+    values[i] = apvts.getRawParameterValue(parameterIDs[i])->load();
+  return values;
+}
+
+void BinaryState::encode(const Values& values, void* dest)
+{
+  auto* p = static_cast<char*>(dest);
+  writeUInt32(p, magic);
+  writeUInt16(p + 4, currentVersion);
+  writeUInt16(p + 6, (juce::uint16)numParameters);
+
+  for (int i = 0; i < numParameters; ++i)
+    writeFloat(p + headerSize + i * (int)sizeof(float), values[i]);
+}
+
+void BinaryState::encode(const Values& values, juce::MemoryBlock& dest)
+{
+  dest.setSize(recordSize);
+  encode(values, dest.getData());
+}
+
+bool BinaryState::isBinaryState(const void* data, size_t size)
+{
+  return data != nullptr && size >= (size_t)headerSize && readUInt32(static_cast<const char*>(data)) == magic;
+}
+
+bool BinaryState::decode(const void* data, size_t size, juce::AudioProcessorValueTreeState& apvts, Values& values)
+{
+  if (!isBinaryState(data, size))
+    return false;
+
+  auto* p = static_cast<const char*>(data);
+  int numStored = readUInt16(p + 6);
+  if (size < (size_t)(headerSize + numStored * (int)sizeof(float)))
+    return false;
+
+  for (int i = 0; i < numParameters; ++i)
+  {
+    if (i < numStored)
+    {
+      values[i] = readFloat(p + headerSize + i * (int)sizeof(float));
+    }
+    else
+    {
+      // older record : the parameter didn't exist yet
+      auto* param = apvts.getParameter(parameterIDs[i]);
+      values[i] = param->convertFrom0to1(param->getDefaultValue());
+    }
+  }
+
+  return true;
+}
+
+bool BinaryState::apply(juce::AudioProcessorValueTreeState& apvts, const Values& values)
+{
+  bool changed = false;
+  for (int i = 0; i < numParameters; ++i)
+  {
+    if (apvts.getRawParameterValue(parameterIDs[i])->load() == values[i])
+      continue;
+
+    auto* param = apvts.getParameter(parameterIDs[i]);
+    param->setValueNotifyingHost(param->convertTo0to1(values[i]));
+    changed = true;
+  }
+  return changed;
+}
+
+//==============================================================================
+PresetBank::PresetBank(const juce::File& file) : mappedFile(file, juce::MemoryMappedFile::readOnly)
+{
+  auto* p = static_cast<const char*>(mappedFile.getData());
+  auto size = mappedFile.getSize();
+
+  if (p == nullptr || size < (size_t)headerSize || readUInt32(p) != magic)
+    return;
+
+  storedSlotSize = readUInt16(p + 6);
+  storedRecordSize = storedSlotSize - nameSize;
+  auto count = (int)readUInt32(p + 8);
+
+  // a truncated file only exposes its complete slots
+  if (storedRecordSize < BinaryState::headerSize)
+    return;
+  numPresets = juce::jmin(count, (int)((size - headerSize) / (size_t)storedSlotSize));
+}
+
+const char* PresetBank::getSlot(int index) const
+{
+  jassert(juce::isPositiveAndBelow(index, numPresets));
+  return static_cast<const char*>(mappedFile.getData()) + headerSize + (size_t)index * (size_t)storedSlotSize;
+}
+
+juce::String PresetBank::getName(int index) const
+{
+  if (!juce::isPositiveAndBelow(index, numPresets))
+    return {};
+
+  auto* slot = getSlot(index);
+  return juce::String::fromUTF8(slot, (int)strnlen(slot, nameSize));
+}
+
+bool PresetBank::recall(int index, juce::AudioProcessorValueTreeState& apvts) const
+{
+  if (!juce::isPositiveAndBelow(index, numPresets))
+    return false;
+
+  BinaryState::Values values;
+  if (!BinaryState::decode(getSlot(index) + nameSize, (size_t)storedRecordSize, apvts, values))
+    return false;
+
+  return BinaryState::apply(apvts, values);
+}
+
+bool PresetBank::write(const juce::File& file, const juce::Array<Preset>& presets)
+{
+  juce::MemoryBlock data((size_t)(headerSize + presets.size() * slotSize), true);
+  auto* p = static_cast<char*>(data.getData());
+
+  writeUInt32(p, magic);
+  writeUInt16(p + 4, currentVersion);
+  writeUInt16(p + 6, (juce::uint16)slotSize);
+  writeUInt32(p + 8, (juce::uint32)presets.size());
+
+  for (int i = 0; i < presets.size(); ++i)
+  {
+    auto* slot = p + headerSize + i * slotSize;
+    auto name = presets[i].name.toUTF8();
+    // the block is zeroed so the name stays terminated
+    std::memcpy(slot, name.getAddress(), juce::jmin((size_t)nameSize - 1, name.sizeInBytes() - 1));
+    BinaryState::encode(presets[i].values, slot + nameSize);
+  }
+
+  return file.replaceWithData(data.getData(), data.getSize());
+}
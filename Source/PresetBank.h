@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    Compact binary state and memory-mapped preset banks.
+
+    A state record is a fixed layout, little endian :
+        uint32 magic ("SEQB"), uint16 version, uint16 numValues, float values[numValues]
+    values[i] is the plain value of parameterIDs[i]. Parameters are only ever
+    appended to parameterIDs, so any record can be read by any build : values
+    the record doesn't have keep their default, extra ones are ignored.
+
+    A bank file is a header followed by fixed size slots (name + state record),
+    so recalling preset i is a pointer computation into the mapped file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <iterator>
+
+namespace BinaryState
+{
+constexpr juce::uint32 magic = 0x42514553; // "SEQB" in the file
+constexpr juce::uint16 currentVersion = 1;
+constexpr int headerSize = 8;
+
+// the offset of a parameter in a record is its index here, never reorder, only append
+constexpr const char* parameterIDs[] = {
+    "LowCut Freq",
+    "HighCut Freq",
+    "Peak Freq",
+    "Peak Gain",
+    "Peak Quality",
+    "LowCut Slope",
+    "HighCut Slope",
+    "LowCut Bypassed",
+    "Peak Bypassed",
+    "HighCut Bypassed",
+    "Analyzer Enabled",
+    "Analyzer Resolution",
+    "Analyzer Mode",
+    "Analyzer View",
+    "Peak Design",
+    "Analyzer Channels"
+};
+
+constexpr int numParameters = (int)std::size(parameterIDs);
+constexpr int recordSize = headerSize + numParameters * (int)sizeof(float);
+
+using Values = std::array<float, numParameters>;
+
+// current plain values of the parameters
+Values capture(juce::AudioProcessorValueTreeState& apvts);
+
+// writes a full record at 'dest', which must hold recordSize bytes
+void encode(const Values& values, void* dest);
+void encode(const Values& values, juce::MemoryBlock& dest);
+
+bool isBinaryState(const void* data, size_t size);
+
+/**
+ reads a record of any version. Values missing from an older record get the default of
+ their parameter. Returns false when this isn't a valid record.
+ */
+bool decode(const void* data, size_t size, juce::AudioProcessorValueTreeState& apvts, Values& values);
+
+/**
+ sets the parameters that differ from 'values' and leaves the others alone.
+ Returns false when nothing had to change.
+ */
+bool apply(juce::AudioProcessorValueTreeState& apvts, const Values& values);
+} // namespace BinaryState
+
+/**
+ Read only view of a bank file, mapped in memory. Opening it checks the header only,
+ the presets are decoded when they are recalled.
+ */
+class PresetBank
+{
+public:
+    static constexpr juce::uint32 magic = 0x50514553; // "SEQP" in the file
+    static constexpr juce::uint16 currentVersion = 1;
+    static constexpr int headerSize = 16;
+    static constexpr int nameSize = 32;
+    static constexpr int slotSize = nameSize + BinaryState::recordSize;
+
+    struct Preset
+    {
+        juce::String name;
+        BinaryState::Values values;
+    };
+
+    explicit PresetBank(const juce::File& file);
+
+    bool isValid() const { return numPresets > 0; }
+    int getNumPresets() const { return numPresets; }
+    juce::String getName(int index) const;
+
+    // decodes slot 'index' straight from the mapping and applies it, false if nothing changed
+    bool recall(int index, juce::AudioProcessorValueTreeState& apvts) const;
+
+    // writes a whole bank, names longer than nameSize - 1 bytes are cut
+    static bool write(const juce::File& file, const juce::Array<Preset>& presets);
+private:
+    const char* getSlot(int index) const;
+
+    juce::MemoryMappedFile mappedFile;
+    int numPresets = 0;
+    int storedSlotSize = 0;
+    int storedRecordSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(PresetBank)
+};
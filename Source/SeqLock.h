@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    Lock free publication of a small value, plain C++ so tools outside the
+    plugin (Tools/TelemetryReader) can read what it writes, including across
+    processes when it lives in shared memory.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ Single writer / many readers publication of a trivially copyable value.
+ The writer never waits, readers retry while a write is in progress and never block the writer.
+ The payload is stored as relaxed atomic words so a torn read is detected, not undefined.
+ */
+template<typename T>
+struct SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock only holds trivially copyable types");
+
+    SeqLock() { write(T{}); }
+
+    // only one thread may write at a time
+    void write(const T& value) noexcept
+    {
+        std::array<std::uint32_t, NumWords> words {};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        auto seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for( size_t i = 0; i < NumWords; ++i )
+            storage[i].store(words[i], std::memory_order_relaxed);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    bool tryRead(T& value) const noexcept
+    {
+        auto before = sequence.load(std::memory_order_acquire);
+        if( before & 1 )
+            return false;
+
+        std::array<std::uint32_t, NumWords> words;
+        for( size_t i = 0; i < NumWords; ++i )
+            words[i] = storage[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if( sequence.load(std::memory_order_relaxed) != before )
+            return false;
+
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return true;
+    }
+
+    T read() const noexcept
+    {
+        T value;
+        while( ! tryRead(value) ) { }
+        return value;
+    }
+private:
+    static constexpr size_t NumWords = (sizeof(T) + sizeof(std::uint32_t) - 1) / sizeof(std::uint32_t);
+    std::array<std::atomic<std::uint32_t>, NumWords> storage;
+    std::atomic<std::uint32_t> sequence { 0 };
+};
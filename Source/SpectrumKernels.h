@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    Post-processing kernels of the spectrum analyzer.
+    Everything here is plain C++ (plus SSE2 when available) so it can be used
+    from the FFT generators without pulling anything else in.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define SIMPLEEQ_SPECTRUM_SSE2 1
+#else
+ #define SIMPLEEQ_SPECTRUM_SSE2 0
+#endif
+
+namespace SpectrumKernels
+{
+/**
+ log2(1 + t) ~ t * (c0 + t * (c1 + t * (c2 + t * c3))) for t in [0, 1)
+ Max abs error is 1.03e-4 in log2, i.e. 3.1e-4 dB once turned into 10 * log10(power).
+ p(0) is exactly 0 so there is no jump when the exponent changes.
+ */
+constexpr float log2C0 = 1.4390133f;
+constexpr float log2C1 = -0.67993581f;
+constexpr float log2C2 = 0.32558133f;
+constexpr float log2C3 = -0.084761100f;
+
+// 10 * log10(x) = log2(x) * 10 * log10(2)
+constexpr float powerDecibelsPerLog2 = 3.0103000f;
+
+inline float fastLog2(float x)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+
+    auto exponent = float(int((bits >> 23) & 0xff) - 127);
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+
+    float mantissa;
+    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+
+    auto t = mantissa - 1.f;
+    return exponent + t * (log2C0 + t * (log2C1 + t * (log2C2 + t * log2C3)));
+}
+
+/**
+ Exponential averaging and peak hold applied on the decibel values.
+ averaging = 0 means no averaging, the closer to 1 the slower the trace.
+ peakDecay is in dB per frame, the peak array is left untouched when it's null.
+ */
+struct Smoothing
+{
+    float averaging = 0.f;
+    float peakDecay = 0.5f;
+};
+
+/**
+ Turns power values (|X|^2) into normalised decibels, in place, in a single pass :
+    - normalisation by numBins (done in the log domain, it is just an offset)
+    - NaN / Inf sanitisation (they become negativeInfinity)
+    - fast log10
+    - clamping to negativeInfinity like juce::Decibels::gainToDecibels
+    - optional exponential averaging (average) and peak hold (peaks)
+
+ average and peaks can be null, otherwise they hold the state of the previous frame
+ and must be numBins long. When averaging is used data receives the averaged values.
+ */
+inline void powerToDecibels(float* data,
+                            float* average,
+                            float* peaks,
+                            int numBins,
+                            float negativeInfinity,
+                            Smoothing smoothing = {})
+{
+    // 20 * log10(|X| / numBins) = 10 * log10(|X|^2) - 20 * log10(numBins)
+    const float offset = -20.f * std::log10(float(numBins));
+    const float maxPower = std::numeric_limits<float>::max();
+    const float a = smoothing.averaging;
+    const float decay = smoothing.peakDecay;
+
+    int i = 0;
+
+#if SIMPLEEQ_SPECTRUM_SSE2
+    const auto vNegInf = _mm_set1_ps(negativeInfinity);
+    const auto vMaxPower = _mm_set1_ps(maxPower);
+    const auto vOffset = _mm_set1_ps(offset);
+    const auto vScale = _mm_set1_ps(powerDecibelsPerLog2);
+    const auto vOne = _mm_set1_ps(1.f);
+    const auto vA = _mm_set1_ps(a);
+    const auto vDecay = _mm_set1_ps(decay);
+    const auto vMantissaMask = _mm_set1_epi32(0x007fffff);
+    const auto vOneBits = _mm_set1_epi32(0x3f800000);
+    const auto vBias = _mm_set1_epi32(127);
+
+    for( ; i + 4 <= numBins; i += 4 )
+    {
+        auto p = _mm_loadu_ps(data + i);
+
+        // false for NaN and +Inf, which is exactly what we want to get rid of
+        auto valid = _mm_cmple_ps(p, vMaxPower);
+
+        auto bits = _mm_castps_si128(p);
+        auto exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), vBias));
+        auto t = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, vMantissaMask), vOneBits)), vOne);
+
+        auto poly = _mm_add_ps(_mm_set1_ps(log2C2), _mm_mul_ps(t, _mm_set1_ps(log2C3)));
+        poly = _mm_add_ps(_mm_set1_ps(log2C1), _mm_mul_ps(t, poly));
+        poly = _mm_add_ps(_mm_set1_ps(log2C0), _mm_mul_ps(t, poly));
+        auto log2 = _mm_add_ps(exponent, _mm_mul_ps(t, poly));
+
+        auto db = _mm_add_ps(_mm_mul_ps(log2, vScale), vOffset);
+        db = _mm_or_ps(_mm_and_ps(valid, db), _mm_andnot_ps(valid, vNegInf));
+        db = _mm_max_ps(db, vNegInf);
+
+        if( average != nullptr )
+        {
+            auto avg = _mm_loadu_ps(average + i);
+            db = _mm_add_ps(db, _mm_mul_ps(vA, _mm_sub_ps(avg, db)));
+            _mm_storeu_ps(average + i, db);
+        }
+
+        if( peaks != nullptr )
+        {
+            auto peak = _mm_sub_ps(_mm_loadu_ps(peaks + i), vDecay);
+            _mm_storeu_ps(peaks + i, _mm_max_ps(_mm_max_ps(db, peak), vNegInf));
+        }
+
+        _mm_storeu_ps(data + i, db);
+    }
+#endif
+
+    // scalar tail, also the whole loop when there is no SSE2. It is branch free so it auto vectorises.
+    for( ; i < numBins; ++i )
+    {
+        auto p = data[i];
+        auto valid = p <= maxPower;
+        auto db = fastLog2(valid ? p : 1.f) * powerDecibelsPerLog2 + offset;
+        db = valid ? std::max(db, negativeInfinity) : negativeInfinity;
+
+        if( average != nullptr )
+        {
+            db += a * (average[i] - db);
+            average[i] = db;
+        }
+
+        if( peaks != nullptr )
+            peaks[i] = std::max(std::max(db, peaks[i] - decay), negativeInfinity);
+
+        data[i] = db;
+    }
+}
+} // namespace SpectrumKernels
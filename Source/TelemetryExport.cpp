@@ -0,0 +1,304 @@
+/*
+  ==============================================================================
+
+    Telemetry tap, shared memory segments and the publisher thread, see
+    TelemetryExport.h
+
+  ==============================================================================
+*/
+
+#include "TelemetryExport.h"
+#include "PluginEditor.h"
+
+#include <numeric>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <unistd.h>
+ #define SIMPLEEQ_TELEMETRY_SHM 1
+#else
+ #define SIMPLEEQ_TELEMETRY_SHM 0
+#endif
+
+//==============================================================================
+void TelemetryTap::allocate()
+{
+  if (ring.empty())
+    ring.assign(ringSize, 0.f);
+}
+
+void TelemetryTap::prepare(double sampleRate)
+{
+  current = {};
+  current.sampleRate = sampleRate;
+  levels.write(current);
+  // the publisher may be pulling right now : it drops what is left in the ring itself
+  discardRequested.store(true, std::memory_order_release);
+}
+
+void TelemetryTap::process(const juce::AudioBuffer<float> &buffer, double processSeconds) noexcept
+{
+  auto numSamples = buffer.getNumSamples();
+  auto numChannels = juce::jmin(2, buffer.getNumChannels());
+  if (numSamples == 0 || numChannels == 0 || current.sampleRate <= 0.0 || ring.empty())
+    return;
+
+  auto seconds = numSamples / current.sampleRate;
+  auto peakFall = (float)std::pow(10.0, -seconds); // 20 dB per second
+  auto meanSquareSmoothing = (float)(1.0 - std::exp(-seconds / 0.3));
+  auto loadSmoothing = (float)(1.0 - std::exp(-seconds / 0.5));
+  auto loadFall = (float)std::exp(-seconds);
+
+  for (int channel = 0; channel < 2; ++channel)
+  {
+    auto *samples = buffer.getReadPointer(juce::jmin(channel, numChannels - 1));
+    auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+    auto blockPeak = juce::jmax(-range.getStart(), range.getEnd());
+
+    float sumOfSquares = 0.f;
+    for (int i = 0; i < numSamples; ++i)
+      sumOfSquares += samples[i] * samples[i];
+
+    current.peak[channel] = juce::jmax(blockPeak, current.peak[channel] * peakFall);
+    current.meanSquare[channel] += meanSquareSmoothing * (sumOfSquares / numSamples - current.meanSquare[channel]);
+  }
+
+  auto load = (float)(processSeconds / seconds);
+  current.dspLoad += loadSmoothing * (load - current.dspLoad);
+  current.dspLoadPeak = juce::jmax(load, current.dspLoadPeak * loadFall);
+  levels.write(current);
+
+  // the spectrum is taken on the mono sum
+  auto *left = buffer.getReadPointer(0);
+  auto *right = buffer.getReadPointer(numChannels - 1);
+  auto write = ringFifo.write(juce::jmin(numSamples, ringFifo.getFreeSpace()));
+  for (int i = 0; i < write.blockSize1; ++i)
+    ring[(size_t)(write.startIndex1 + i)] = 0.5f * (left[i] + right[i]);
+  for (int i = 0; i < write.blockSize2; ++i)
+    ring[(size_t)(write.startIndex2 + i)] = 0.5f * (left[write.blockSize1 + i] + right[write.blockSize1 + i]);
+}
+
+int TelemetryTap::pullSamples(float *dest, int maxSamples) noexcept
+{
+  // samples from before prepare(), reading them would mix two streams in one window
+  if (discardRequested.exchange(false, std::memory_order_acquire))
+    ringFifo.finishedRead(ringFifo.getNumReady());
+
+  auto read = ringFifo.read(juce::jmin(maxSamples, ringFifo.getNumReady()));
+  std::copy(ring.begin() + read.startIndex1, ring.begin() + read.startIndex1 + read.blockSize1, dest);
+  std::copy(ring.begin() + read.startIndex2, ring.begin() + read.startIndex2 + read.blockSize2, dest + read.blockSize1);
+  return read.blockSize1 + read.blockSize2;
+}
+
+//==============================================================================
+namespace
+{
+/**
+ One thread for every publisher of the process, shared through juce::SharedResourcePointer.
+ The list lock is only held to copy or change the list, never during a transform, so
+ publishers coming and going on the message thread wait for one publish() at most.
+ */
+struct TelemetryService : juce::Thread
+{
+  TelemetryService() : juce::Thread("SimpleEq telemetry") { startThread(); }
+  ~TelemetryService() override { stopThread(1000); }
+
+  void add(TelemetryPublisher *publisher)
+  {
+    const juce::ScopedLock sl(lock);
+    publishers.addIfNotAlreadyThere(publisher);
+  }
+
+  // once this returns the publisher thread won't touch 'publisher' anymore
+  void remove(TelemetryPublisher *publisher)
+  {
+    {
+      const juce::ScopedLock sl(lock);
+      publishers.removeFirstMatchingValue(publisher);
+    }
+
+    // it may be publishing it from its copy of the list : wait until it's done
+    const juce::ScopedLock sl(publishing);
+  }
+
+  void run() override
+  {
+    while (!threadShouldExit())
+    {
+      {
+        const juce::ScopedLock sl(lock);
+        pending.clearQuick();
+        pending.addArray(publishers);
+      }
+
+      for (auto *publisher : pending)
+      {
+        const juce::ScopedLock sl(publishing);
+        {
+          // removed since the copy, it may be gone already
+          const juce::ScopedLock listLock(lock);
+          if (!publishers.contains(publisher))
+            continue;
+        }
+        publisher->publish();
+      }
+      wait(1000 / TelemetryPublisher::publishRateHz);
+    }
+  }
+
+  juce::CriticalSection lock, publishing;
+  juce::Array<TelemetryPublisher *> publishers;
+  // publisher thread only
+  juce::Array<TelemetryPublisher *> pending;
+};
+
+std::atomic<int> numSegmentsCreated{0};
+}
+
+// the transform state of one publisher, same tables as the editor analyzer
+struct TelemetryPublisher::Analysis
+{
+  static constexpr FFTOrder order = FFTOrder::order2048;
+  static constexpr int fftSize = 1 << order;
+  static constexpr float negativeInfinity = -120.f;
+
+  Analysis()
+  {
+    history.prepare(fftSize);
+    incoming.resize(fftSize);
+    timeData.resize(fftSize);
+    freqData.resize(fftSize);
+    power.resize(fftSize / 2);
+
+    // powerToDecibels divides by fftSize / 2, which gives dBFS for a window summing to fftSize.
+    // The coherent gain of the actual window makes up the rest, so a full scale sine reads 0 dBFS
+    auto *window = tables->getWindow(order);
+    auto windowSum = std::accumulate(window, window + fftSize, 0.0);
+    coherentGainOffsetDb = (float)(20.0 * std::log10(fftSize / windowSum));
+  }
+
+  void buildBands(double sampleRate)
+  {
+    bandsSampleRate = sampleRate;
+    auto binWidth = sampleRate / fftSize;
+    for (int band = 0; band < Telemetry::numBands; ++band)
+    {
+      // a band narrower than a bin still reads the bin it falls in
+      auto first = juce::jlimit(0, fftSize / 2 - 1, (int)(Telemetry::bandEdge(band) / binWidth));
+      auto last = juce::jlimit(first + 1, fftSize / 2, (int)std::ceil(Telemetry::bandEdge(band + 1) / binWidth));
+      bandBins[(size_t)band] = {first, last};
+    }
+  }
+
+  juce::SharedResourcePointer<FFTTables> tables;
+  juce::SharedResourcePointer<TelemetryService> service;
+  AnalyzerHistory history;
+  std::vector<float> incoming, power;
+  std::vector<juce::dsp::Complex<float>> timeData, freqData;
+  std::array<std::pair<int, int>, Telemetry::numBands> bandBins{};
+  double bandsSampleRate = 0.0;
+  float coherentGainOffsetDb = 0.f;
+};
+
+TelemetryPublisher::TelemetryPublisher(TelemetryTap &tapToRead, const juce::String &segmentName)
+    : tap(tapToRead),
+      name(segmentName.isNotEmpty() ? segmentName
+                                    : Telemetry::namePrefix + juce::String(juce::SystemStats::getProcessId())
+                                          + "." + juce::String(numSegmentsCreated++)),
+      analysis(std::make_unique<Analysis>())
+{
+#if SIMPLEEQ_TELEMETRY_SHM
+  auto path = "/" + name;
+  auto fd = shm_open(path.toRawUTF8(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    return;
+
+  void *mapped = MAP_FAILED;
+  if (ftruncate(fd, sizeof(Telemetry::Segment)) == 0)
+    mapped = mmap(nullptr, sizeof(Telemetry::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd); // the mapping stays
+
+  if (mapped == MAP_FAILED)
+  {
+    shm_unlink(path.toRawUTF8());
+    return;
+  }
+
+  segment = new (mapped) Telemetry::Segment();
+  segment->version = Telemetry::currentVersion;
+  segment->segmentSize = sizeof(Telemetry::Segment);
+  segment->processId = (std::int32_t)juce::SystemStats::getProcessId();
+  // readers check the magic first, it goes in last
+  std::atomic_thread_fence(std::memory_order_release);
+  segment->magic = Telemetry::magic;
+
+  tap.allocate();
+  analysis->service->add(this);
+#endif
+}
+
+TelemetryPublisher::~TelemetryPublisher()
+{
+  // after this the publisher thread doesn't know us anymore
+  analysis->service->remove(this);
+
+#if SIMPLEEQ_TELEMETRY_SHM
+  if (segment != nullptr)
+  {
+    segment->magic = 0;
+    munmap(segment, sizeof(Telemetry::Segment));
+    shm_unlink(("/" + name).toRawUTF8());
+  }
+#endif
+}
+
+void TelemetryPublisher::publish()
+{
+  auto &a = *analysis;
+  auto levels = tap.readLevels();
+
+  // everything that came since the last call goes through the history, only the latest window is analysed
+  for (int numPulled; (numPulled = tap.pullSamples(a.incoming.data(), (int)a.incoming.size())) > 0;)
+    a.history.push(a.incoming.data(), numPulled);
+
+  if (levels.sampleRate > 0.0 && levels.sampleRate != a.bandsSampleRate)
+    a.buildBands(levels.sampleRate);
+
+  Telemetry::Frame frame;
+  frame.updateCount = ++updateCount;
+  frame.sampleRate = levels.sampleRate;
+  for (int channel = 0; channel < 2; ++channel)
+  {
+    frame.peakDb[channel] = juce::Decibels::gainToDecibels(levels.peak[channel], Analysis::negativeInfinity);
+    frame.rmsDb[channel] = juce::Decibels::gainToDecibels(std::sqrt(levels.meanSquare[channel]), Analysis::negativeInfinity);
+  }
+  frame.dspLoad = levels.dspLoad;
+  frame.dspLoadPeak = levels.dspLoadPeak;
+
+  auto window = a.history.getLatest(Analysis::fftSize);
+  auto *windowTable = a.tables->getWindow(Analysis::order);
+  for (int i = 0; i < window.firstSize; ++i)
+    a.timeData[(size_t)i] = {window.first[i] * windowTable[i], 0.f};
+  for (int i = 0; i < window.secondSize; ++i)
+    a.timeData[(size_t)(window.firstSize + i)] = {window.second[i] * windowTable[window.firstSize + i], 0.f};
+
+  a.tables->getFFT(Analysis::order).perform(a.timeData.data(), a.freqData.data(), false);
+
+  const int numBins = Analysis::fftSize / 2;
+  for (int k = 0; k < numBins; ++k)
+    a.power[(size_t)k] = std::norm(a.freqData[(size_t)k]);
+  SpectrumKernels::powerToDecibels(a.power.data(), nullptr, nullptr, numBins, Analysis::negativeInfinity);
+
+  for (int band = 0; band < Telemetry::numBands; ++band)
+  {
+    auto bins = a.bandBins[(size_t)band];
+    frame.bandsDb[band] = a.bandsSampleRate > 0.0
+                              ? juce::jmax(Analysis::negativeInfinity,
+                                           *std::max_element(a.power.begin() + bins.first, a.power.begin() + bins.second)
+                                               + a.coherentGainOffsetDb)
+                              : Analysis::negativeInfinity;
+  }
+
+  segment->frame.write(frame);
+}
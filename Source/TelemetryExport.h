@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    Telemetry for dashboards : the latest spectrum, levels and dsp load of an
+    instance, published in a POSIX shared memory segment (TelemetryLayout.h)
+    so an external process can watch hundreds of instances without editors.
+
+    The audio thread only feeds a TelemetryTap : meters and a sample ring,
+    wait free. One background thread per process pulls every tap at
+    publishRateHz, runs the transform and writes the segments.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SeqLock.h"
+#include "TelemetryLayout.h"
+
+/**
+ What the audio thread hands over. process() never waits : the levels go through a SeqLock
+ and the samples through a ring that drops the newest ones when the publisher is late.
+ */
+struct TelemetryTap
+{
+    struct Levels
+    {
+        double sampleRate = 0.0;
+        float peak[2] {};
+        float meanSquare[2] {};
+        float dspLoad = 0.f;
+        float dspLoadPeak = 0.f;
+    };
+
+    // message thread, before the tap is used. Never shrinks
+    void allocate();
+    bool isAllocated() const { return ! ring.empty(); }
+
+    // while the audio thread is stopped, e.g. prepareToPlay. The publisher may still be
+    // reading : the ring is left alone, its next pullSamples() drops what is in it
+    void prepare(double sampleRate);
+
+    // audio thread. 'processSeconds' is what the block took to process
+    void process(const juce::AudioBuffer<float>& buffer, double processSeconds) noexcept;
+
+    // publisher thread
+    Levels readLevels() const noexcept { return levels.read(); }
+    int pullSamples(float* dest, int maxSamples) noexcept;
+private:
+    static constexpr int ringSize = 16384;
+
+    std::vector<float> ring;
+    juce::AbstractFifo ringFifo { ringSize };
+    std::atomic<bool> discardRequested { false };
+    SeqLock<Levels> levels;
+
+    // audio thread state, the ballistics follow the duration of each block
+    Levels current;
+};
+
+/**
+ Owns the shared memory segment of one instance and registers itself with the process
+ wide publisher thread. Created and destroyed on the message thread, destroying it removes the segment.
+ */
+class TelemetryPublisher
+{
+public:
+    // an empty name gives namePrefix + "<pid>.<n>"
+    TelemetryPublisher(TelemetryTap& tapToRead, const juce::String& segmentName);
+    ~TelemetryPublisher();
+
+    bool isValid() const { return segment != nullptr; }
+    const juce::String& getSegmentName() const { return name; }
+
+    // publisher thread
+    void publish();
+
+    static constexpr int publishRateHz = 20;
+private:
+    TelemetryTap& tap;
+    juce::String name;
+    Telemetry::Segment* segment = nullptr;
+
+    struct Analysis;
+    std::unique_ptr<Analysis> analysis;
+    juce::uint64 updateCount = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(TelemetryPublisher)
+};
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    Layout of the telemetry shared memory segments, shared by the plugin
+    (TelemetryExport) and Tools/TelemetryReader. Plain C++, no JUCE.
+
+    One segment per instance, named namePrefix + "<pid>.<n>" unless the host
+    side gave it a name. The publisher is the only writer, readers map it
+    read only and retry through the SeqLock, so any number of them costs the
+    plugin nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "SeqLock.h"
+
+namespace Telemetry
+{
+constexpr std::uint32_t magic = 0x54514553; // "SEQT" in memory
+constexpr std::uint32_t currentVersion = 1;
+constexpr const char* namePrefix = "SimpleEq.";
+
+constexpr int numBands = 64;
+constexpr float minFrequency = 20.f;
+constexpr float maxFrequency = 20000.f;
+
+// bands are log spaced, band 'i' covers [bandEdge(i), bandEdge(i + 1))
+inline float bandEdge(int band)
+{
+    return minFrequency * std::pow(maxFrequency / minFrequency, float(band) / numBands);
+}
+
+struct Frame
+{
+    std::uint64_t updateCount = 0;
+    double sampleRate = 0.0;
+    // left, right in dBFS, with meter ballistics (peak falls 20 dB/s, rms over ~300 ms)
+    float peakDb[2] {};
+    float rmsDb[2] {};
+    // processBlock time over the block duration, smoothed and held peak
+    float dspLoad = 0.f;
+    float dspLoadPeak = 0.f;
+    // output of the chain, dBFS : the highest bin of each band, corrected for the window's
+    // coherent gain so a full scale sine reads 0 dB. Floor at -120
+    float bandsDb[numBands] {};
+};
+
+struct Segment
+{
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint32_t segmentSize = 0;
+    std::int32_t processId = 0;
+    SeqLock<Frame> frame;
+
+    bool isValid() const
+    {
+        return magic == Telemetry::magic && version == currentVersion && segmentSize == sizeof(Segment);
+    }
+};
+} // namespace Telemetry
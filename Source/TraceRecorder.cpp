@@ -0,0 +1,248 @@
+/*
+  ==============================================================================
+
+    Per thread trace rings and their Chrome trace export, see TraceRecorder.h
+
+  ==============================================================================
+*/
+
+#include "TraceRecorder.h"
+#include <chrono>
+
+TraceRecorder& TraceRecorder::getInstance()
+{
+  // never destroyed : threads still running at exit give their slot back into it
+  static auto *instance = new TraceRecorder();
+  return *instance;
+}
+
+TraceRecorder::TraceRecorder() : epoch(now())
+{
+}
+
+juce::uint64 TraceRecorder::now() noexcept
+{
+  return (juce::uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TraceRecorder::setEnabled(bool shouldRecord)
+{
+  if (shouldRecord && buffers == nullptr)
+  {
+    buffers = std::make_unique<ThreadBuffer[]>(maxThreads);
+    pool.store(buffers.get(), std::memory_order_release);
+  }
+  enabled.store(shouldRecord, std::memory_order_relaxed);
+}
+
+struct TraceRecorder::SlotOwner
+{
+  ~SlotOwner()
+  {
+    if (buffer != nullptr)
+    {
+      auto& recorder = getInstance();
+      buffer->releasedAt.store((juce::uint64)recorder.numReleased.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      buffer->claimed.store(false, std::memory_order_release);
+      recorder.numReleased.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  ThreadBuffer *buffer = nullptr;
+  int releasesSeen = -1;
+};
+
+TraceRecorder::ThreadBuffer* TraceRecorder::getThreadBuffer() noexcept
+{
+  thread_local SlotOwner slot;
+
+  if (slot.buffer != nullptr)
+    return slot.buffer;
+
+  // every slot was taken the last time we looked and none came back since
+  auto releases = numReleased.load(std::memory_order_acquire);
+  if (releases == slot.releasesSeen)
+    return nullptr;
+
+  slot.buffer = claimSlot();
+  if (slot.buffer == nullptr && pool.load(std::memory_order_acquire) != nullptr)
+    slot.releasesSeen = releases;
+  return slot.buffer;
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::claimSlot() noexcept
+{
+  auto* slots = pool.load(std::memory_order_acquire);
+  if (slots == nullptr)
+    return nullptr;
+
+  auto tryClaim = [](ThreadBuffer& buffer) {
+    auto expected = false;
+    return buffer.claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+  };
+
+  ThreadBuffer* claimed = nullptr;
+
+  // never used slots first, then the one given back the longest ago : the events of the threads
+  // that exited stay in the export as long as possible
+  for (int i = 0; i < maxThreads && claimed == nullptr; ++i)
+    if (!slots[i].ready.load(std::memory_order_acquire) && tryClaim(slots[i]))
+      claimed = &slots[i];
+
+  while (claimed == nullptr)
+  {
+    ThreadBuffer* oldest = nullptr;
+    for (int i = 0; i < maxThreads; ++i)
+      if (!slots[i].claimed.load(std::memory_order_relaxed) &&
+          (oldest == nullptr || slots[i].releasedAt.load(std::memory_order_relaxed) < oldest->releasedAt.load(std::memory_order_relaxed)))
+        oldest = &slots[i];
+
+    if (oldest == nullptr)
+      return nullptr;
+    if (tryClaim(*oldest))
+      claimed = oldest;
+  }
+
+  auto& buffer = *claimed;
+  buffer.ownerSequence.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto writeIndex = buffer.writeIndex.load(std::memory_order_relaxed);
+  buffer.previousOwnedFrom.store(buffer.ownedFrom.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  buffer.previousName.store(buffer.name.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  buffer.ownedFrom.store(writeIndex, std::memory_order_relaxed);
+  buffer.name.store(juce::MessageManager::existsAndIsCurrentThread() ? "Message thread" : nullptr,
+                    std::memory_order_relaxed);
+
+  buffer.ownerSequence.fetch_add(1, std::memory_order_release);
+  buffer.ready.store(true, std::memory_order_release);
+  return &buffer;
+}
+
+void TraceRecorder::setCurrentThreadName(const char* name) noexcept
+{
+  if (auto* buffer = getThreadBuffer())
+    buffer->name.store(name, std::memory_order_relaxed);
+}
+
+void TraceRecorder::record(const char* name, juce::uint64 start, juce::uint64 end) noexcept
+{
+  auto* buffer = getThreadBuffer();
+  if (buffer == nullptr)
+    return;
+
+  auto index = buffer->writeIndex.load(std::memory_order_relaxed);
+  auto& event = buffer->events[index % eventsPerThread];
+  event.name.store(name, std::memory_order_relaxed);
+  event.start.store(start, std::memory_order_relaxed);
+  event.end.store(end, std::memory_order_relaxed);
+  buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::clear() noexcept
+{
+  auto* slots = pool.load(std::memory_order_acquire);
+  if (slots == nullptr)
+    return;
+
+  for (int i = 0; i < maxThreads; ++i)
+    slots[i].clearedAt.store(slots[i].writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+juce::String TraceRecorder::exportChromeTrace() const
+{
+  juce::MemoryOutputStream out;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto separator = [&out, &first] {
+    if (!first)
+      out << ",\n";
+    first = false;
+  };
+
+  auto* slots = pool.load(std::memory_order_acquire);
+  auto numThreads = slots != nullptr ? maxThreads : 0;
+
+  struct Copy
+  {
+    const char* name;
+    juce::uint64 start, end;
+  };
+  std::vector<Copy> copies;
+
+  for (int slot = 0; slot < numThreads; ++slot)
+  {
+    auto& buffer = slots[slot];
+    if (!buffer.ready.load(std::memory_order_acquire))
+      continue;
+
+    auto oldestKept = [](juce::uint64 writeIndex) {
+      return writeIndex > (juce::uint64)eventsPerThread ? writeIndex - eventsPerThread : 0;
+    };
+
+    // who owned the slot when, read before the events : a claim during the export drops the slot this time
+    auto sequence = buffer.ownerSequence.load(std::memory_order_acquire);
+    if ((sequence & 1) != 0)
+      continue;
+
+    auto owner = sequence / 2 - 1;
+    auto ownedFrom = buffer.ownedFrom.load(std::memory_order_relaxed);
+    auto previousOwnedFrom = buffer.previousOwnedFrom.load(std::memory_order_relaxed);
+    auto* threadName = buffer.name.load(std::memory_order_relaxed);
+    auto* previousName = buffer.previousName.load(std::memory_order_relaxed);
+
+    auto writeIndex = buffer.writeIndex.load(std::memory_order_acquire);
+    auto from = juce::jmax(oldestKept(writeIndex), buffer.clearedAt.load(std::memory_order_relaxed));
+    if (owner > 0)
+      from = juce::jmax(from, previousOwnedFrom);
+
+    copies.clear();
+    for (auto i = from; i < writeIndex; ++i)
+    {
+      auto& event = buffer.events[i % eventsPerThread];
+      copies.push_back({event.name.load(std::memory_order_relaxed),
+                        event.start.load(std::memory_order_relaxed),
+                        event.end.load(std::memory_order_relaxed)});
+    }
+
+    // like a seqlock : whatever the writer reached while we copied is not trusted
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto firstValid = oldestKept(buffer.writeIndex.load(std::memory_order_relaxed));
+    if (buffer.ownerSequence.load(std::memory_order_relaxed) != sequence)
+      continue;
+
+    // one tid per owner : the slot, plus maxThreads for each thread that had it before
+    auto tidOf = [slot](int ownerIndex) { return slot + maxThreads * ownerIndex; };
+    auto writeThreadName = [&](int tid, const char* name) {
+      separator();
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+          << ",\"args\":{\"name\":" << juce::JSON::toString(name != nullptr ? juce::String(name) : "Thread " + juce::String(tid))
+          << "}}";
+    };
+
+    writeThreadName(tidOf(owner), threadName);
+    if (owner > 0 && from < ownedFrom)
+      writeThreadName(tidOf(owner - 1), previousName);
+
+    for (size_t i = 0; i < copies.size(); ++i)
+    {
+      if (from + i < firstValid || copies[i].name == nullptr)
+        continue;
+
+      separator();
+      out << "{\"name\":" << juce::JSON::toString(juce::String(copies[i].name))
+          << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << (from + i < ownedFrom ? tidOf(owner - 1) : tidOf(owner))
+          << ",\"ts\":" << juce::String((double)(copies[i].start - epoch) / 1000.0, 3)
+          << ",\"dur\":" << juce::String((double)(copies[i].end - copies[i].start) / 1000.0, 3) << "}";
+    }
+  }
+
+  out << "]}";
+  return out.toString();
+}
+
+bool TraceRecorder::writeChromeTrace(const juce::File& file) const
+{
+  return file.replaceWithText(exportChromeTrace());
+}
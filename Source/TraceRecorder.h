@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    Hot path trace markers, exported as Chrome trace events (chrome://tracing
+    or ui.perfetto.dev) so the audio and message threads show on one timeline.
+
+    Every thread writes its own ring of events, so recording is a few relaxed
+    stores and never waits. Disabled, a marker costs one relaxed load and a
+    branch. The rings keep the most recent eventsPerThread events per thread.
+    A thread gives its ring back when it exits, the next new thread reuses it
+    (the events of the previous owner stay in the export until overwritten).
+
+        TRACE_SCOPE("processBlock");
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+class TraceRecorder
+{
+public:
+    static constexpr int maxThreads = 32;
+    static constexpr int eventsPerThread = 8192;
+
+    static TraceRecorder& getInstance();
+
+    // message thread. The rings are allocated the first time it's enabled, never on the hot path
+    void setEnabled(bool shouldRecord);
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    // labels the calling thread in the export, 'name' must outlive the recorder (a literal)
+    void setCurrentThreadName(const char* name) noexcept;
+
+    // the export starts after this point
+    void clear() noexcept;
+
+    // can run while recording, events overwritten during the export are left out
+    juce::String exportChromeTrace() const;
+    bool writeChromeTrace(const juce::File& file) const;
+
+    // nanoseconds on the steady clock
+    static juce::uint64 now() noexcept;
+
+    struct Scope
+    {
+        explicit Scope(const char* eventName) noexcept
+            : name(eventName), start(getInstance().isEnabled() ? now() : 0) {}
+
+        ~Scope() noexcept
+        {
+            if( start != 0 )
+                getInstance().record(name, start, now());
+        }
+
+        const char* name;
+        juce::uint64 start;
+    };
+private:
+    TraceRecorder();
+
+    struct Event
+    {
+        std::atomic<const char*> name { nullptr };
+        std::atomic<juce::uint64> start { 0 }, end { 0 };
+    };
+
+    /**
+     Single writer : the thread that claimed it. Every claim is a new owner with its own
+     tid in the export, the events before ownedFrom belong to the previous one.
+     ownerSequence is odd while a claim rewrites the owner fields, it counts two per claim.
+     */
+    struct ThreadBuffer
+    {
+        std::array<Event, eventsPerThread> events;
+        std::atomic<juce::uint64> writeIndex { 0 };
+        std::atomic<juce::uint64> clearedAt { 0 };
+        std::atomic<juce::uint64> ownedFrom { 0 }, previousOwnedFrom { 0 };
+        std::atomic<const char*> name { nullptr }, previousName { nullptr };
+        std::atomic<int> ownerSequence { 0 };
+        std::atomic<juce::uint64> releasedAt { 0 };
+        std::atomic<bool> claimed { false };
+        std::atomic<bool> ready { false };
+    };
+
+    // thread_local, gives the slot back when its thread exits
+    struct SlotOwner;
+
+    ThreadBuffer* getThreadBuffer() noexcept;
+    ThreadBuffer* claimSlot() noexcept;
+    void record(const char* name, juce::uint64 start, juce::uint64 end) noexcept;
+
+    std::atomic<bool> enabled { false };
+    std::unique_ptr<ThreadBuffer[]> buffers;
+    std::atomic<ThreadBuffer*> pool { nullptr };
+    // a thread that found every slot taken only looks again once one was given back
+    std::atomic<int> numReleased { 0 };
+    juce::uint64 epoch = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(TraceRecorder)
+};
+
+#define TRACE_SCOPE(name) TraceRecorder::Scope JUCE_JOIN_MACRO(traceScope, __LINE__)(name)
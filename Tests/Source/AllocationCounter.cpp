@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    Replacement of the global operator new / delete, see AllocationCounter.h
+
+  ==============================================================================
+*/
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+ #include <malloc.h>
+#endif
+
+namespace
+{
+// the counter of the innermost Scope of this thread, trivially initialised so it is safe from operator new
+thread_local int *activeCounter = nullptr;
+
+void *allocate(std::size_t size) noexcept
+{
+  if (activeCounter != nullptr)
+    ++*activeCounter;
+  return std::malloc(size != 0 ? size : 1);
+}
+
+void *allocateAligned(std::size_t size, std::size_t alignment) noexcept
+{
+  if (activeCounter != nullptr)
+    ++*activeCounter;
+#if defined(_WIN32)
+  return _aligned_malloc(size != 0 ? size : 1, alignment);
+#else
+  void *ptr = nullptr;
+  return posix_memalign(&ptr, alignment < sizeof(void *) ? sizeof(void *) : alignment, size != 0 ? size : 1) == 0 ? ptr : nullptr;
+#endif
+}
+
+void freeAligned(void *ptr) noexcept
+{
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+}
+
+namespace AllocationCounter
+{
+Scope::Scope() : previous(activeCounter)
+{
+  activeCounter = &count;
+}
+
+Scope::~Scope()
+{
+  activeCounter = previous;
+}
+}
+
+void *operator new(std::size_t size)
+{
+  if (auto *ptr = allocate(size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+  if (auto *ptr = allocate(size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+  if (auto *ptr = allocateAligned(size, (std::size_t)alignment))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+  if (auto *ptr = allocateAligned(size, (std::size_t)alignment))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+  return allocateAligned(size, (std::size_t)alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+  return allocateAligned(size, (std::size_t)alignment);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { freeAligned(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { freeAligned(ptr); }
@@ -0,0 +1,32 @@
+/*
+  ==============================================================================
+
+    Counts the heap allocations of the calling thread. The global operator
+    new / delete of the test executable are replaced (AllocationCounter.cpp),
+    only the threads that have a Scope alive are counted (by the innermost).
+
+        AllocationCounter::Scope allocations;
+        pathProducer.process(bounds, sampleRate);
+        expectEquals(allocations.getCount(), 0);
+
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace AllocationCounter
+{
+struct Scope
+{
+  Scope();
+  ~Scope();
+
+  int getCount() const { return count; }
+private:
+  int count = 0;
+  int *previous = nullptr;
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+};
+}
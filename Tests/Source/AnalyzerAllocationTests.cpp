@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    The GUI side of the analyzer must not allocate once it runs : for every
+    Analyzer Resolution / Mode / View / Channels combination,
+    PathProducer::process is warmed up (changeOrder, the low band and the
+    spectrogram allocate lazily) then must make no allocation at all for a
+    few seconds of frames.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "AllocationCounter.h"
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/PluginEditor.h"
+
+namespace
+{
+class AnalyzerAllocationTest : public juce::UnitTest
+{
+public:
+  AnalyzerAllocationTest() : juce::UnitTest("PathProducer::process allocations", "Analyzer") {}
+
+  void runTest() override
+  {
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    // a bit more than a 60 Hz frame of audio, and enough warm up to fill the 8192 points low band history
+    constexpr int blocksPerFrame = 2;
+    constexpr int warmupFrames = 100;
+    constexpr int measuredFrames = 240;
+
+    SingleChannelSampleFifo<SimpleEqAudioProcessor::BlockType> left{Channel::Left}, right{Channel::Right};
+    left.prepare(blockSize);
+    right.prepare(blockSize);
+
+    PathProducer producer(left, right);
+    const juce::Rectangle<float> bounds{0.f, 0.f, 600.f, 300.f};
+
+    juce::AudioBuffer<float> block(2, blockSize);
+    auto &random = getRandom();
+    double phase = 0.0;
+
+    // what processBlock and a render tick do, the fifo writes are part of the audio path so they count too
+    auto runFrame = [&]
+    {
+      for (int b = 0; b < blocksPerFrame; ++b)
+      {
+        for (int i = 0; i < blockSize; ++i)
+        {
+          phase += juce::MathConstants<double>::twoPi * 997.0 / sampleRate;
+          auto sine = 0.5f * (float)std::sin(phase);
+          block.setSample(0, i, sine + 0.05f * (random.nextFloat() - 0.5f));
+          block.setSample(1, i, -sine + 0.05f * (random.nextFloat() - 0.5f));
+        }
+        right.update(block);
+        left.update(block);
+      }
+      producer.process(bounds, sampleRate);
+    };
+
+    const juce::StringArray resolutions{"2048", "4096", "8192"};
+    for (int resolution = 0; resolution < resolutions.size(); ++resolution)
+    {
+      for (auto multiResolution : {false, true})
+      {
+        for (auto spectrogram : {false, true})
+        {
+          for (auto midSide : {false, true})
+          {
+            beginTest("Resolution " + resolutions[resolution] +
+                      (multiResolution ? ", multi resolution" : ", single") +
+                      (spectrogram ? ", spectrogram" : ", spectrum") + (midSide ? ", mid/side" : ""));
+
+            // what renderTick() does with the parameter values
+            producer.setFFTOrder(static_cast<FFTOrder>(minFFTOrder + resolution));
+            producer.setMultiResolution(multiResolution);
+            producer.setSpectrogramEnabled(spectrogram);
+            producer.setMidSideEnabled(midSide);
+
+            for (int frame = 0; frame < warmupFrames; ++frame)
+              runFrame();
+
+            int numAllocations = 0;
+            {
+              AllocationCounter::Scope allocations;
+              for (int frame = 0; frame < measuredFrames; ++frame)
+                runFrame();
+              numAllocations = allocations.getCount();
+            }
+
+            expectEquals(numAllocations, 0, "allocations over " + juce::String(measuredFrames) + " frames");
+          }
+        }
+      }
+    }
+  }
+};
+
+AnalyzerAllocationTest analyzerAllocationTest;
+}
@@ -0,0 +1,395 @@
+/*
+  ==============================================================================
+
+    The analyzer fifos between the audio thread and the editor, hammered from
+    two threads : random block sizes, random reader timing and re-prepare()
+    while the reader is busy. Every element / sample carries where it came
+    from, so the reader checks
+
+      - integrity : nothing torn, nothing half written, no size from another prepare(),
+      - ordering  : never older than what was read before,
+      - drops     : only where the fifo is allowed to drop, and how many.
+
+    Meant to run under ThreadSanitizer too, see Main.cpp.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+#include <thread>
+
+namespace
+{
+constexpr double stressSeconds = 1.5;
+
+double getSeconds() { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+
+// random pauses, so both sides get to be the late one
+void pause(juce::Random &random)
+{
+  auto dice = random.nextInt(100);
+  if (dice < 2)
+    std::this_thread::sleep_for(std::chrono::microseconds(random.nextInt(500)));
+  else if (dice < 20)
+    std::this_thread::yield();
+}
+
+//==============================================================================
+// an element of Fifo<T> : epoch (number of prepare() calls), sequence in that epoch, then a payload of both
+float payload(int epoch, int sequence, int index) { return (float)((sequence * 31 + index * 7 + epoch) % 65536); }
+
+void fill(std::vector<float> &element, int epoch, int sequence)
+{
+  element[0] = (float)epoch;
+  element[1] = (float)sequence;
+  for (size_t i = 2; i < element.size(); ++i)
+    element[i] = payload(epoch, sequence, (int)i);
+}
+
+void fill(juce::AudioBuffer<float> &element, int epoch, int sequence)
+{
+  for (int channel = 0; channel < element.getNumChannels(); ++channel)
+  {
+    auto *samples = element.getWritePointer(channel);
+    samples[0] = (float)epoch;
+    samples[1] = (float)sequence;
+    for (int i = 2; i < element.getNumSamples(); ++i)
+      samples[i] = payload(epoch, sequence, i + channel);
+  }
+}
+
+bool isIntact(const std::vector<float> &element, size_t expectedSize)
+{
+  if (element.size() != expectedSize)
+    return false;
+  for (size_t i = 2; i < element.size(); ++i)
+    if (element[i] != payload((int)element[0], (int)element[1], (int)i))
+      return false;
+  return true;
+}
+
+bool isIntact(const juce::AudioBuffer<float> &element, size_t expectedSize)
+{
+  if (element.getNumChannels() != 2 || (size_t)element.getNumSamples() != expectedSize)
+    return false;
+  for (int channel = 0; channel < element.getNumChannels(); ++channel)
+  {
+    auto *samples = element.getReadPointer(channel);
+    if (samples[0] != element.getSample(0, 0) || samples[1] != element.getSample(0, 1))
+      return false;
+    for (int i = 2; i < element.getNumSamples(); ++i)
+      if (samples[i] != payload((int)samples[0], (int)samples[1], i + channel))
+        return false;
+  }
+  return true;
+}
+
+int getEpoch(const std::vector<float> &element) { return (int)element[0]; }
+int getSequence(const std::vector<float> &element) { return (int)element[1]; }
+int getEpoch(const juce::AudioBuffer<float> &element) { return (int)element.getSample(0, 0); }
+int getSequence(const juce::AudioBuffer<float> &element) { return (int)element.getSample(0, 1); }
+
+void prepare(Fifo<std::vector<float>> &fifo, std::vector<float> &element, int size)
+{
+  fifo.prepare((size_t)size);
+  element.assign((size_t)size, 0.f);
+}
+
+void prepare(Fifo<juce::AudioBuffer<float>> &fifo, juce::AudioBuffer<float> &element, int size)
+{
+  fifo.prepare(2, size);
+  element.setSize(2, size);
+}
+
+//==============================================================================
+class FifoStressTest : public juce::UnitTest
+{
+public:
+  FifoStressTest() : juce::UnitTest("Fifo and SingleChannelSampleFifo under stress", "Stress") {}
+
+  void runTest() override
+  {
+    beginTest("Fifo<std::vector<float>>");
+    stressFifo<std::vector<float>>();
+
+    beginTest("Fifo<juce::AudioBuffer<float>>");
+    stressFifo<juce::AudioBuffer<float>>();
+
+    beginTest("SingleChannelSampleFifo overwrites the oldest samples");
+    checkOverwriteOldest();
+
+    beginTest("SingleChannelSampleFifo");
+    stressSampleFifo();
+  }
+
+private:
+  /**
+   The producer numbers the elements it managed to push, so within an epoch the reader must
+   see every sequence number in turn, and the first element of a new epoch is its number 0 :
+   a prepare() may only lose what was queued before it.
+   */
+  template <typename T>
+  void stressFifo()
+  {
+    constexpr int maxElementsPerEpoch = 20000;
+
+    Fifo<T> fifo;
+    T element;
+    prepare(fifo, element, 64);
+
+    // epoch of every prepare() -> the size it set, written before the prepare() itself
+    std::vector<std::atomic<int>> sizes(4096);
+    sizes[0] = 64;
+
+    std::atomic<bool> finished{false};
+    std::atomic<int> lastEpoch{0};
+    int pushed = 0, dropped = 0;
+
+    std::thread producer([&, seed = getRandom().nextInt64()]
+                         {
+                           juce::Random random(seed);
+                           int epoch = 0, sequence = 0;
+                           for (auto end = getSeconds() + stressSeconds; getSeconds() < end;)
+                           {
+                             if ((random.nextInt(2000) == 0 || sequence == maxElementsPerEpoch) && epoch + 1 < (int)sizes.size())
+                             {
+                               auto size = 3 + random.nextInt(1000);
+                               sizes[(size_t)epoch + 1] = size;
+                               prepare(fifo, element, size);
+                               sequence = 0;
+                               lastEpoch = ++epoch;
+                             }
+
+                             fill(element, epoch, sequence);
+                             if (fifo.push(element))
+                             {
+                               ++sequence;
+                               ++pushed;
+                             }
+                             else
+                             {
+                               ++dropped;
+                             }
+                             pause(random);
+                           }
+                           finished = true; });
+
+    int pulled = 0, discarded = 0, torn = 0, misordered = 0, epochsSeen = 0;
+    int epoch = 0, nextSequence = 0;
+    juce::Random random(getRandom().nextInt64());
+    T received;
+
+    auto check = [&]
+    {
+      if (!isIntact(received, (size_t)sizes[(size_t)juce::jlimit(0, (int)sizes.size() - 1, getEpoch(received))].load()))
+      {
+        ++torn;
+        return;
+      }
+
+      // after a discardAll() : start over from whatever comes next
+      if (epoch < 0)
+      {
+        epoch = getEpoch(received);
+        nextSequence = getSequence(received);
+      }
+
+      if (getEpoch(received) == epoch && getSequence(received) != nextSequence)
+        ++misordered;
+      else if (getEpoch(received) < epoch || (getEpoch(received) > epoch && getSequence(received) != 0))
+        ++misordered;
+      else if (getEpoch(received) > epoch)
+        ++epochsSeen;
+
+      epoch = getEpoch(received);
+      nextSequence = getSequence(received) + 1;
+    };
+
+    while (!finished)
+    {
+      if (random.nextInt(1000) == 0)
+      {
+        discarded += fifo.getNumAvailableForReading();
+        fifo.discardAll();
+        // what was discarded is a legal gap
+        epoch = -1;
+        continue;
+      }
+
+      if (fifo.pull(received))
+      {
+        ++pulled;
+        check();
+      }
+      pause(random);
+    }
+    producer.join();
+
+    while (fifo.pull(received))
+    {
+      ++pulled;
+      check();
+    }
+
+    logMessage(juce::String(pushed) + " pushed, " + juce::String(dropped) + " dropped while full, " + juce::String(pulled) +
+               " pulled, " + juce::String(lastEpoch.load()) + " prepare(), " + juce::String(epochsSeen) + " seen by the reader");
+
+    expectEquals(torn, 0, "torn or stale elements");
+    expectEquals(misordered, 0, "elements out of order or missing");
+    expect(pulled > 0, "nothing went through");
+    expect(pulled + discarded <= pushed, "more elements out than in");
+  }
+
+  //==============================================================================
+  // every sample is the count of samples given to update() before it, modulo 2^24 so it stays exact in a float
+  static constexpr juce::int64 counterRange = 1 << 24;
+  static constexpr int maxBlockSize = 2048;
+  // the largest ring stressSampleFifo() asks for : 4 * maxBlockSize
+  static constexpr juce::int64 maxCapacity = 8192;
+
+  static void fillCounter(juce::AudioBuffer<float> &block, juce::int64 &counter)
+  {
+    for (int i = 0; i < block.getNumSamples(); ++i, ++counter)
+    {
+      block.setSample(Channel::Left, i, (float)(counter % counterRange));
+      block.setSample(Channel::Right, i, -1.f);
+    }
+  }
+
+  // the full counter of 'sample', knowing that it is below 'bound' (and not 2^24 samples below)
+  static juce::int64 unwrap(float sample, juce::int64 bound)
+  {
+    auto low = (juce::int64)sample;
+    auto counter = bound - ((bound - low) % counterRange + counterRange) % counterRange;
+    return counter == bound ? counter - counterRange : counter;
+  }
+
+  void checkOverwriteOldest()
+  {
+    SingleChannelSampleFifo<juce::AudioBuffer<float>> fifo{Channel::Left};
+    fifo.prepare(256);
+    fifo.attachConsumer();
+
+    juce::AudioBuffer<float> block(2, 256), read;
+    juce::int64 counter = 0;
+    for (int i = 0; i < 200; ++i)
+    {
+      fillCounter(block, counter);
+      fifo.update(block);
+    }
+
+    // the writer never waits : the reader finds the newest half of the ring, whole buffers on its grid
+    expect(fifo.getNumCompleteBuffersAvailable() == (int)(maxCapacity / 2 / 256), "newest half of the ring available");
+    expect(fifo.getAudioBuffer(read), "read after an overrun");
+    expectEquals((juce::int64)read.getSample(0, 0), counter - maxCapacity / 2, "first sample after an overrun");
+
+    int reads = 1;
+    while (fifo.getAudioBuffer(read))
+      ++reads;
+    expectEquals((juce::int64)read.getSample(0, 255), counter - 1, "last sample read");
+    expectEquals(reads, (int)(maxCapacity / 2 / 256), "buffers read after an overrun");
+    fifo.detachConsumer();
+  }
+
+  /**
+   The audio thread writes a running counter in random block sizes and now and then
+   re-prepares the fifo, the reader attaches / detaches and reads at random times.
+   A read must be consecutive counter values, after everything read before, and recent :
+   no older than a ring behind what was written when it started, never from before a
+   prepare() that was over when it started.
+   */
+  void stressSampleFifo()
+  {
+    SingleChannelSampleFifo<juce::AudioBuffer<float>> fifo{Channel::Left};
+    fifo.prepare(512);
+
+    std::atomic<bool> finished{false};
+    std::atomic<juce::int64> written{0}, preparedAt{0};
+    std::atomic<int> numPrepares{0};
+
+    std::thread producer([&, seed = getRandom().nextInt64()]
+                         {
+                           juce::Random random(seed);
+                           juce::AudioBuffer<float> block(2, maxBlockSize);
+                           juce::int64 counter = 0;
+                           for (auto end = getSeconds() + stressSeconds; getSeconds() < end;)
+                           {
+                             if (random.nextInt(3000) == 0)
+                             {
+                               fifo.prepare(1 + random.nextInt(maxBlockSize));
+                               preparedAt = counter;
+                               ++numPrepares;
+                             }
+
+                             block.setSize(2, 1 + random.nextInt(maxBlockSize), false, false, true);
+                             fillCounter(block, counter);
+                             fifo.update(block);
+                             written = counter;
+                             pause(random);
+                           }
+                           finished = true; });
+
+    juce::Random random(getRandom().nextInt64());
+    juce::AudioBuffer<float> read;
+    juce::int64 lastRead = -1;
+    juce::int64 numReads = 0, samplesRead = 0, samplesSkipped = 0;
+    int torn = 0, misordered = 0, stale = 0, attached = 0;
+
+    while (!finished)
+    {
+      if (!fifo.hasConsumer())
+      {
+        fifo.attachConsumer();
+        ++attached;
+      }
+      else if (random.nextInt(500) == 0)
+      {
+        fifo.detachConsumer();
+        continue;
+      }
+
+      auto writtenBefore = written.load();
+      auto floor = preparedAt.load();
+      if (fifo.getNumCompleteBuffersAvailable() > 0 && fifo.getAudioBuffer(read))
+      {
+        ++numReads;
+        // 'written' is stored after update() returned : the read may hold the block being written
+        auto first = unwrap(read.getSample(0, 0), written.load() + maxBlockSize);
+        for (int i = 1; i < read.getNumSamples(); ++i)
+          if ((juce::int64)read.getSample(0, i) != (first + i) % counterRange)
+          {
+            ++torn;
+            break;
+          }
+
+        if (first <= lastRead)
+          ++misordered;
+        if (first < writtenBefore - maxCapacity || first < floor)
+          ++stale;
+        if (lastRead >= 0 && first > lastRead + 1)
+          samplesSkipped += first - lastRead - 1;
+
+        lastRead = first + read.getNumSamples() - 1;
+        samplesRead += read.getNumSamples();
+      }
+      pause(random);
+    }
+    producer.join();
+    if (fifo.hasConsumer())
+      fifo.detachConsumer();
+
+    logMessage(juce::String(numReads) + " reads, " + juce::String(samplesRead) + " samples read, " + juce::String(samplesSkipped) +
+               " skipped (overwritten, detached or re-prepared), " + juce::String(numPrepares.load()) + " prepare(), " +
+               juce::String(attached) + " attach");
+
+    expectEquals(torn, 0, "reads that aren't consecutive samples");
+    expectEquals(misordered, 0, "reads older than the previous one");
+    expectEquals(stale, 0, "reads from before the ring or the last prepare()");
+    expect(numReads > 0, "nothing went through");
+  }
+};
+
+FifoStressTest fifoStressTest;
+}
@@ -0,0 +1,75 @@
+#include "GoldenFiles.h"
+
+namespace
+{
+const char magic[] = "SEQGOLD1";
+constexpr size_t magicSize = 8;
+
+juce::File directory;
+bool updating = false;
+
+juce::File findDefaultDirectory()
+{
+  // Builds/LinuxMakefile/build/SimpleEqTests -> Tests/Golden
+  for (auto folder = juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory();
+       folder != folder.getParentDirectory(); folder = folder.getParentDirectory())
+  {
+    if (folder.getChildFile("SimpleEqTests.jucer").existsAsFile())
+      return folder.getChildFile("Golden");
+  }
+
+  return juce::File::getCurrentWorkingDirectory().getChildFile("Golden");
+}
+
+juce::File getFile(const juce::String &name)
+{
+  return GoldenFiles::getDirectory().getChildFile(name + ".golden");
+}
+}
+
+namespace GoldenFiles
+{
+juce::File getDirectory()
+{
+  if (directory == juce::File())
+    directory = findDefaultDirectory();
+  return directory;
+}
+
+void setDirectory(const juce::File &newDirectory) { directory = newDirectory; }
+
+bool isUpdating() { return updating; }
+void setUpdating(bool shouldUpdate) { updating = shouldUpdate; }
+
+bool read(const juce::String &name, std::vector<float> &samples)
+{
+  juce::MemoryBlock data;
+  if (!getFile(name).loadFileAsData(data) || data.getSize() < magicSize + 4
+      || std::memcmp(data.getData(), magic, magicSize) != 0)
+    return false;
+
+  juce::MemoryInputStream stream(data, false);
+  stream.skipNextBytes((juce::int64)magicSize);
+
+  auto numSamples = stream.readInt();
+  if (numSamples < 0 || (size_t)stream.getNumBytesRemaining() != (size_t)numSamples * sizeof(float))
+    return false;
+
+  samples.resize((size_t)numSamples);
+  for (auto &sample : samples)
+    sample = stream.readFloat();
+  return true;
+}
+
+bool write(const juce::String &name, const std::vector<float> &samples)
+{
+  juce::MemoryOutputStream stream;
+  stream.write(magic, magicSize);
+  stream.writeInt((int)samples.size());
+  for (auto sample : samples)
+    stream.writeFloat(sample);
+
+  auto file = getFile(name);
+  return file.getParentDirectory().createDirectory().wasOk() && file.replaceWithData(stream.getData(), stream.getDataSize());
+}
+}
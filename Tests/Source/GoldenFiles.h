@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    Reference outputs kept in Tests/Golden, one file per test case :
+    the magic "SEQGOLD1", the number of samples (int32) then the samples
+    (float32), little endian.
+
+    The folder is found by walking up from the executable to the one holding
+    SimpleEqTests.jucer, --golden-dir=<folder> points somewhere else and
+    --update-golden rewrites the files instead of comparing with them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+namespace GoldenFiles
+{
+juce::File getDirectory();
+void setDirectory(const juce::File &directory);
+
+bool isUpdating();
+void setUpdating(bool shouldUpdate);
+
+bool read(const juce::String &name, std::vector<float> &samples);
+bool write(const juce::String &name, const std::vector<float> &samples);
+}
@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    Output of the filter chain, the way processBlock runs it : fixed signals go
+    through a MonoChain for a grid of ChainSettings and sample rates, and
+
+      - match Tests/Golden within a tolerance, the samples that aren't bit
+        exact are counted in the log,
+      - don't depend on the block size they were processed with.
+
+    After an intended change of the output, rerun with --update-golden and
+    commit the new files.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GoldenFiles.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+constexpr int signalLength = 8192;
+constexpr int referenceBlockSize = 512;
+
+// another compiler may fuse the multiply-adds of the filter loop : that moves these outputs by up to 1e-3
+constexpr float goldenTolerance = 2.0e-3f;
+// the filters flush a state under 1e-8 to zero at the end of every block (JUCE_SNAP_TO_ZERO), nothing else may differ
+constexpr float blockSizeTolerance = 1.0e-6f;
+
+struct GoldenCase
+{
+  const char *name;
+  ChainSettings settings;
+};
+
+ChainSettings makeSettings(float lowCutFreq, Slope lowCutSlope, float peakFreq, float peakGainInDecibels, float peakQuality,
+                           float highCutFreq, Slope highCutSlope)
+{
+  ChainSettings settings;
+  settings.lowCutFreq = lowCutFreq;
+  settings.lowCutSlope = lowCutSlope;
+  settings.peakFreq = peakFreq;
+  settings.peakGainInDecibels = peakGainInDecibels;
+  settings.peakQuality = peakQuality;
+  settings.highCutFreq = highCutFreq;
+  settings.highCutSlope = highCutSlope;
+  return settings;
+}
+
+std::vector<GoldenCase> makeCases()
+{
+  std::vector<GoldenCase> cases;
+  // the parameter defaults
+  cases.push_back({"default", makeSettings(20.f, Slope_12, 750.f, 0.f, 1.f, 20000.f, Slope_12)});
+  cases.push_back({"steep_cuts", makeSettings(200.f, Slope_48, 1000.f, 6.f, 2.f, 5000.f, Slope_48)});
+  cases.push_back({"mixed_slopes", makeSettings(80.f, Slope_24, 3000.f, -12.f, 0.5f, 12000.f, Slope_32)});
+
+  auto matched = makeSettings(20.f, Slope_12, 16000.f, 12.f, 1.f, 20000.f, Slope_12);
+  matched.peakDesign = PeakDesign_Matched;
+  cases.push_back({"matched_peak", matched});
+
+  cases.push_back({"narrow_boost", makeSettings(30.f, Slope_12, 100.f, 24.f, 10.f, 18000.f, Slope_24)});
+
+  auto bypasses = makeSettings(500.f, Slope_48, 2000.f, 12.f, 1.f, 8000.f, Slope_24);
+  bypasses.lowCutBypassed = true;
+  bypasses.peakBypassed = true;
+  cases.push_back({"bypasses", bypasses});
+  return cases;
+}
+
+// a log sweep, white noise, then two tones on a DC step. Computed in double from nothing
+// but the sample rate, so it is the same signal the golden files were recorded with.
+std::vector<float> makeTestSignal(double sampleRate)
+{
+  constexpr double twoPi = juce::MathConstants<double>::twoPi;
+  std::vector<float> signal((size_t)signalLength);
+
+  const double top = juce::jmin(20000.0, 0.45 * sampleRate);
+  double phase = 0.0;
+  juce::uint32 noise = 12345u;
+
+  for (int n = 0; n < signalLength; ++n)
+  {
+    double value;
+    if (n < 3072)
+    {
+      auto frequency = 20.0 * std::pow(top / 20.0, n / 3071.0);
+      phase += twoPi * frequency / sampleRate;
+      value = 0.5 * std::sin(phase);
+    }
+    else if (n < 6144)
+    {
+      noise = noise * 1664525u + 1013904223u;
+      value = double(noise >> 8) / 16777216.0 - 0.5;
+    }
+    else
+    {
+      auto t = double(n - 6144) / sampleRate;
+      value = 0.25 + 0.3 * std::sin(twoPi * 1000.0 * t) + 0.2 * std::sin(twoPi * 7000.0 * t);
+    }
+    signal[(size_t)n] = (float)value;
+  }
+  return signal;
+}
+
+// what prepareToPlay / processBlock do to one channel, block sizes are taken from the list in turn
+std::vector<float> render(const ChainSettings &settings, double sampleRate, const std::vector<int> &blockSizes)
+{
+  juce::ScopedNoDenormals noDenormals;
+
+  MonoChain chain;
+  prepareChainForInPlaceUpdates(chain);
+  chain.prepare({sampleRate, (juce::uint32)signalLength, 1});
+  applyChainCoefficients(chain, makeChainCoefficients(settings, sampleRate));
+
+  auto output = makeTestSignal(sampleRate);
+  size_t next = 0;
+  for (int position = 0; position < signalLength;)
+  {
+    auto numSamples = juce::jmin(blockSizes[next++ % blockSizes.size()], signalLength - position);
+    float *channels[] = {output.data() + position};
+    juce::dsp::AudioBlock<float> block(channels, 1, (size_t)numSamples);
+    processChainStages(chain, juce::dsp::ProcessContextReplacing<float>(block));
+    position += numSamples;
+  }
+  return output;
+}
+
+struct Difference
+{
+  int numDifferent = 0;
+  float maximum = 0.f;
+};
+
+Difference compare(const std::vector<float> &a, const std::vector<float> &b)
+{
+  Difference difference;
+  for (size_t i = 0; i < a.size(); ++i)
+  {
+    if (a[i] != b[i])
+      ++difference.numDifferent;
+    difference.maximum = juce::jmax(difference.maximum, std::abs(a[i] - b[i]));
+  }
+  return difference;
+}
+
+class GoldenOutputTest : public juce::UnitTest
+{
+public:
+  GoldenOutputTest() : juce::UnitTest("Filter chain output", "Audio") {}
+
+  void runTest() override
+  {
+    // a fixed seed : a failure has to be reproducible from the log
+    juce::Random random(47);
+    std::vector<int> varyingBlockSizes;
+    for (int i = 0; i < 64; ++i)
+      varyingBlockSizes.push_back(1 + random.nextInt(1024));
+
+    const std::vector<std::vector<int>> blockSizes{{1}, {17}, {64}, {4096}, {signalLength}, varyingBlockSizes};
+
+    for (auto &goldenCase : makeCases())
+    {
+      for (auto sampleRate : {44100.0, 48000.0, 96000.0})
+      {
+        auto name = juce::String(goldenCase.name) + "_" + juce::String((int)sampleRate);
+        beginTest(name);
+
+        auto reference = render(goldenCase.settings, sampleRate, {referenceBlockSize});
+        checkGolden(name, reference);
+
+        for (auto &sizes : blockSizes)
+        {
+          auto blocks = sizes.size() == 1 ? juce::String(sizes.front()) : juce::String("varying size");
+          auto difference = compare(render(goldenCase.settings, sampleRate, sizes), reference);
+          expect(difference.maximum <= blockSizeTolerance, "blocks of " + blocks + " differ by " + juce::String(difference.maximum) +
+                                                               " from blocks of " + juce::String(referenceBlockSize));
+        }
+      }
+    }
+  }
+
+private:
+  void checkGolden(const juce::String &name, const std::vector<float> &output)
+  {
+    if (GoldenFiles::isUpdating())
+    {
+      expect(GoldenFiles::write(name, output), "couldn't write " + name + " in " + GoldenFiles::getDirectory().getFullPathName());
+      return;
+    }
+
+    std::vector<float> golden;
+    if (!GoldenFiles::read(name, golden))
+    {
+      expect(false, "no golden file " + name + " in " + GoldenFiles::getDirectory().getFullPathName() +
+                        ", see --golden-dir and --update-golden");
+      return;
+    }
+    expectEquals((int)golden.size(), (int)output.size(), "golden length");
+    if (golden.size() != output.size())
+      return;
+
+    auto difference = compare(output, golden);
+    expect(difference.maximum <= goldenTolerance, "differs by " + juce::String(difference.maximum) + " from the golden file");
+    if (difference.numDifferent > 0)
+      logMessage(juce::String(difference.numDifferent) + " samples not bit exact, " + juce::String(difference.maximum) + " apart at most");
+  }
+};
+
+GoldenOutputTest goldenOutputTest;
+}
@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    SimpleEqTests : runs every juce::UnitTest compiled in, returns 1 when one
+    of them failed.
+
+        SimpleEqTests [--category=<name>] [--seed=<n>]
+                      [--golden-dir=<folder>] [--update-golden]
+
+    --update-golden records the outputs of the golden tests instead of
+    checking them (see GoldenFiles.h).
+
+    Linux : open SimpleEqTests.jucer in the Projucer, save, then
+        make -C Builds/LinuxMakefile CONFIG=Debug
+
+    The stress tests under ThreadSanitizer (make clean first, the objects
+    must all be built with it) :
+        make -C Builds/LinuxMakefile CONFIG=Debug CXXFLAGS=-fsanitize=thread LDFLAGS=-fsanitize=thread
+        Builds/LinuxMakefile/build/SimpleEqTests --category=Stress
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GoldenFiles.h"
+
+int main(int argc, char *argv[])
+{
+  juce::ScopedJuceInitialiser_GUI gui;
+  juce::ArgumentList args(argc, argv);
+
+  auto seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue()
+                                            : juce::Random::getSystemRandom().nextInt64();
+
+  if (args.containsOption("--golden-dir"))
+    GoldenFiles::setDirectory(args.getFileForOption("--golden-dir"));
+  GoldenFiles::setUpdating(args.containsOption("--update-golden"));
+
+  juce::UnitTestRunner runner;
+  runner.setAssertOnFailure(false);
+
+  if (args.containsOption("--category"))
+    runner.runTestsInCategory(args.getValueForOption("--category"), seed);
+  else
+    runner.runAllTests(seed);
+
+  int failures = 0;
+  for (int i = 0; i < runner.getNumResults(); ++i)
+    failures += runner.getResult(i)->failures;
+
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    Reads the telemetry segments published by SimpleEq instances
+    (Source/TelemetryExport.h) and prints one line per instance : levels,
+    dsp load and the spectrum as a row of characters. No JUCE needed :
+
+        cmake -S . -B build && cmake --build build
+
+    or by hand (add -lrt on older glibc)
+
+        c++ -std=c++17 -O2 -I../../Source TelemetryReader.cpp -o telemetry-reader
+
+        telemetry-reader                 every segment found in /dev/shm (Linux)
+        telemetry-reader NAME...         these segments, e.g. SimpleEq.4242.0
+        telemetry-reader --watch ...     refresh twice a second
+
+    Segments are mapped read only, reading them never slows the plugin down.
+
+  ==============================================================================
+*/
+
+#include "TelemetryLayout.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+std::vector<std::string> findSegments()
+{
+    std::vector<std::string> names;
+#if defined(__linux__)
+    if( auto* dir = opendir("/dev/shm") )
+    {
+        while( auto* entry = readdir(dir) )
+            if( std::strncmp(entry->d_name, Telemetry::namePrefix, std::strlen(Telemetry::namePrefix)) == 0 )
+                names.push_back(entry->d_name);
+        closedir(dir);
+    }
+#endif
+    return names;
+}
+
+const Telemetry::Segment* mapSegment(const std::string& name)
+{
+    auto fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+    if( fd < 0 )
+        return nullptr;
+
+    // a shorter segment (another version) would fault when read past its end
+    struct stat info;
+    if( fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Telemetry::Segment) )
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    auto* mapped = mmap(nullptr, sizeof(Telemetry::Segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return mapped == MAP_FAILED ? nullptr : static_cast<const Telemetry::Segment*>(mapped);
+}
+
+// one character per band, from the floor to 0 dBFS
+std::string spectrumRow(const Telemetry::Frame& frame, float floorDb = -90.f)
+{
+    static const char levels[] = " .:-=+*#%@";
+    constexpr int numLevels = sizeof(levels) - 1;
+
+    std::string row;
+    for( auto db : frame.bandsDb )
+    {
+        auto position = (db - floorDb) / -floorDb;
+        auto index = (int)(position * (numLevels - 1) + 0.5f);
+        row += levels[index < 0 ? 0 : (index >= numLevels ? numLevels - 1 : index)];
+    }
+    return row;
+}
+
+// a frame is written in microseconds : still odd after a few ms, its writer died half way through one
+bool readFrame(const Telemetry::Segment* segment, Telemetry::Frame& frame)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(5);
+    do
+    {
+        if( segment->frame.tryRead(frame) )
+            return true;
+        std::this_thread::yield();
+    }
+    while( std::chrono::steady_clock::now() < deadline );
+
+    return false;
+}
+
+void printSegment(const std::string& name, const Telemetry::Segment* segment)
+{
+    if( segment == nullptr || ! segment->isValid() )
+    {
+        std::printf("%-24s  (not a telemetry segment of this version)\n", name.c_str());
+        return;
+    }
+
+    Telemetry::Frame frame;
+    auto readable = readFrame(segment, frame);
+
+    // a crashed host never removed its segments
+    auto alive = kill(segment->processId, 0) == 0;
+
+    if( ! readable )
+    {
+        std::printf("%-24s %s\n", name.c_str(), alive ? "(torn : no complete frame within 5 ms)"
+                                                     : "(stale) (torn : the host died while writing a frame)");
+        return;
+    }
+
+    std::printf("%-24s %s%6.0f Hz  L %6.1f/%6.1f  R %6.1f/%6.1f dB  load %5.1f%% (peak %5.1f%%)  |%s|\n",
+                name.c_str(), alive ? "" : "(stale) ",
+                frame.sampleRate,
+                frame.peakDb[0], frame.rmsDb[0], frame.peakDb[1], frame.rmsDb[1],
+                100.f * frame.dspLoad, 100.f * frame.dspLoadPeak,
+                spectrumRow(frame).c_str());
+}
+}
+
+int main(int argc, char* argv[])
+{
+    bool watch = false;
+    std::vector<std::string> names;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        if( std::strcmp(argv[i], "--watch") == 0 )
+            watch = true;
+        else
+            names.push_back(argv[i]);
+    }
+
+    const bool discover = names.empty();
+
+    do
+    {
+        if( discover )
+            names = findSegments();
+
+        if( watch )
+            std::printf("\033[2J\033[H");
+
+        if( names.empty() )
+            std::printf("no telemetry segment found, is SIMPLEEQ_TELEMETRY=1 set for the host?\n");
+
+        for( auto& name : names )
+        {
+            auto* segment = mapSegment(name);
+            printSegment(name, segment);
+            if( segment != nullptr )
+                munmap(const_cast<Telemetry::Segment*>(segment), sizeof(Telemetry::Segment));
+        }
+
+        std::fflush(stdout);
+        if( watch )
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    while( watch );
+
+    return 0;
+}